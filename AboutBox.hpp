@@ -1,13 +1,13 @@
-// AboutBox.hpp --- version info dialog
-// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
-// This file is public domain software.
-
-#ifndef ABOUTBOX_HPP_
-#define ABOUTBOX_HPP_
-#ifndef _INC_WINDOWS
-    #include <windows.h>
-#endif
-
-void ShowAboutBox(HINSTANCE hInst, HWND hwnd);
-
-#endif  // ndef ABOUTBOX_HPP_
+// AboutBox.hpp --- version info dialog
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef ABOUTBOX_HPP_
+#define ABOUTBOX_HPP_
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+
+void ShowAboutBox(HINSTANCE hInst, HWND hwnd);
+
+#endif  // ndef ABOUTBOX_HPP_
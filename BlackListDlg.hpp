@@ -1,13 +1,13 @@
-// BlackListDlg.hpp --- black list dialog
-// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
-// This file is public domain software.
-
-#ifndef BLACK_LIST_DLG_HPP_
-#define BLACK_LIST_DLG_HPP_
-#ifndef _INC_WINDOWS
-    #include <windows.h>
-#endif
-
-void ShowBlackListDlg(HINSTANCE hInst, HWND hwnd);
-
-#endif  // ndef BLACK_LIST_DLG_HPP_
+// BlackListDlg.hpp --- black list dialog
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef BLACK_LIST_DLG_HPP_
+#define BLACK_LIST_DLG_HPP_
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+
+void ShowBlackListDlg(HINSTANCE hInst, HWND hwnd);
+
+#endif  // ndef BLACK_LIST_DLG_HPP_
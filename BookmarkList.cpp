@@ -0,0 +1,575 @@
+// BookmarkList.cpp --- the items and the indexes of the bookmarks
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "BookmarkList.hpp"
+#include "UTF8Codec.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// "SBBM" + version
+static const char s_szMagic[] = "SBBM";
+#define BOOKMARKS_VERSION   1
+
+#define MAX_IMPORT_TAG      8192
+#define MAX_IMPORT_TEXT     1024
+
+static std::wstring DoLower(const std::wstring& str)
+{
+    std::wstring ret = str;
+    LowerText(ret);
+    return ret;
+}
+
+static void DoWriteVarint(std::string& buf, unsigned long value)
+{
+    while (value >= 0x80)
+    {
+        buf += char((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    buf += char(value);
+}
+
+static bool DoReadVarint(const unsigned char *& pb, const unsigned char *end,
+                         unsigned long& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (pb >= end)
+            return false;
+        unsigned char b = *pb++;
+        value |= (unsigned long)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return value <= 0xFFFFFFFF;
+    }
+    return false;
+}
+
+static void DoWriteString(std::string& buf, const std::wstring& str)
+{
+    std::string utf8 = WideToUTF8(str);
+    DoWriteVarint(buf, (unsigned long)utf8.size());
+    buf += utf8;
+}
+
+static bool DoReadString(const unsigned char *& pb, const unsigned char *end,
+                         std::wstring& str)
+{
+    unsigned long len;
+    if (!DoReadVarint(pb, end, len) || (unsigned long)(end - pb) < len)
+        return false;
+    str = UTF8ToWide((const char *)pb, len);
+    pb += len;
+    return true;
+}
+
+MBookmarkList::MBookmarkList() : m_sorted_dirty(true)
+{
+}
+
+void MBookmarkList::clear()
+{
+    m_items.clear();
+    m_url2index.clear();
+    m_sorted.clear();
+    m_sorted_dirty = true;
+}
+
+size_t MBookmarkList::size() const
+{
+    return m_items.size();
+}
+
+const BOOKMARK& MBookmarkList::operator[](BOOKMARK_ID index) const
+{
+    return m_items[index];
+}
+
+/*static*/ std::wstring MBookmarkList::NormalizeURL(const wchar_t *url)
+{
+    std::wstring ret = url;
+    size_t i = ret.find_first_not_of(L" \t\n\r\f\v");
+    size_t j = ret.find_last_not_of(L" \t\n\r\f\v");
+    if (i == std::wstring::npos)
+        return std::wstring();
+    ret = ret.substr(i, j - i + 1);
+
+    // drop fragment
+    size_t k = ret.find(L'#');
+    if (k != std::wstring::npos)
+        ret.resize(k);
+
+    // lowercase scheme and host
+    size_t host_begin = ret.find(L"://");
+    std::wstring scheme;
+    if (host_begin != std::wstring::npos)
+    {
+        scheme = DoLower(ret.substr(0, host_begin));
+        host_begin += 3;
+    }
+    else
+    {
+        host_begin = 0;
+    }
+    size_t host_end = ret.find_first_of(L"/?", host_begin);
+    if (host_end == std::wstring::npos)
+        host_end = ret.size();
+    ret = DoLower(ret.substr(0, host_end)) + ret.substr(host_end);
+
+    // drop default port
+    std::wstring host = ret.substr(host_begin, host_end - host_begin);
+    if ((scheme == L"http" && host.size() > 3 && host.compare(host.size() - 3, 3, L":80") == 0) ||
+        (scheme == L"https" && host.size() > 4 && host.compare(host.size() - 4, 4, L":443") == 0))
+    {
+        size_t colon = ret.rfind(L':', host_end);
+        ret.erase(colon, host_end - colon);
+        host_end = colon;
+    }
+
+    // "http://example.com/" --> "http://example.com"
+    if (host_end + 1 == ret.size() && ret[host_end] == L'/')
+        ret.resize(host_end);
+
+    return ret;
+}
+
+void MBookmarkList::DoIndex(BOOKMARK_ID index)
+{
+    const BOOKMARK& item = m_items[index];
+    if (!item.m_is_folder && !item.m_deleted && item.m_url.size())
+    {
+        m_url2index[NormalizeURL(item.m_url.c_str())] = index;
+    }
+    m_sorted_dirty = true;
+}
+
+BOOKMARK_ID MBookmarkList::AddFolder(BOOKMARK_ID parent, const std::wstring& title)
+{
+    BOOKMARK item;
+    item.m_parent = parent;
+    item.m_is_folder = true;
+    item.m_deleted = false;
+    item.m_title = title;
+
+    m_items.push_back(item);
+    BOOKMARK_ID index = BOOKMARK_ID(m_items.size() - 1);
+    DoIndex(index);
+    return index;
+}
+
+BOOKMARK_ID MBookmarkList::AddBookmark(BOOKMARK_ID parent, const std::wstring& title,
+                                       const std::wstring& url, const std::wstring& tags)
+{
+    BOOKMARK item;
+    item.m_parent = parent;
+    item.m_is_folder = false;
+    item.m_deleted = false;
+    item.m_title = title;
+    item.m_url = url;
+    item.m_tags = tags;
+
+    m_items.push_back(item);
+    BOOKMARK_ID index = BOOKMARK_ID(m_items.size() - 1);
+    DoIndex(index);
+    return index;
+}
+
+bool MBookmarkList::Remove(BOOKMARK_ID index)
+{
+    if (index >= m_items.size() || m_items[index].m_deleted)
+        return false;
+
+    BOOKMARK& item = m_items[index];
+    item.m_deleted = true;
+    m_sorted_dirty = true;
+
+    if (item.m_is_folder)
+    {
+        for (BOOKMARK_ID i = 0; i < m_items.size(); ++i)
+        {
+            if (m_items[i].m_parent == index)
+                Remove(i);
+        }
+        return true;
+    }
+
+    // re-point the index to a duplicate, if any
+    std::wstring key = NormalizeURL(item.m_url.c_str());
+    auto it = m_url2index.find(key);
+    if (it != m_url2index.end() && it->second == index)
+    {
+        m_url2index.erase(it);
+        for (BOOKMARK_ID i = 0; i < m_items.size(); ++i)
+        {
+            const BOOKMARK& other = m_items[i];
+            if (!other.m_deleted && !other.m_is_folder &&
+                NormalizeURL(other.m_url.c_str()) == key)
+            {
+                m_url2index[key] = i;
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+BOOKMARK_ID MBookmarkList::Find(const wchar_t *url) const
+{
+    auto it = m_url2index.find(NormalizeURL(url));
+    if (it == m_url2index.end())
+        return BOOKMARK_ROOT;
+    return it->second;
+}
+
+bool MBookmarkList::IsBookmarked(const wchar_t *url) const
+{
+    return Find(url) != BOOKMARK_ROOT;
+}
+
+void MBookmarkList::DoSort() const
+{
+    if (!m_sorted_dirty)
+        return;
+
+    m_sorted.clear();
+    for (BOOKMARK_ID i = 0; i < m_items.size(); ++i)
+    {
+        const BOOKMARK& item = m_items[i];
+        if (item.m_deleted || item.m_is_folder)
+            continue;
+
+        if (item.m_title.size())
+            m_sorted.push_back(std::make_pair(DoLower(item.m_title), i));
+
+        // index the URL without its scheme and "www."
+        std::wstring url = DoLower(item.m_url);
+        size_t k = url.find(L"://");
+        if (k != std::wstring::npos)
+            url.erase(0, k + 3);
+        if (url.find(L"www.") == 0)
+            url.erase(0, 4);
+        m_sorted.push_back(std::make_pair(url, i));
+    }
+    std::sort(m_sorted.begin(), m_sorted.end());
+
+    m_sorted_dirty = false;
+}
+
+size_t MBookmarkList::Search(const wchar_t *prefix, std::vector<BOOKMARK_ID>& results,
+                             size_t max_count) const
+{
+    results.clear();
+
+    std::wstring key = DoLower(prefix);
+    if (key.empty())
+        return 0;
+
+    DoSort();
+
+    const std::vector<key_type>& sorted = m_sorted;
+    std::vector<key_type>::const_iterator it, end = sorted.end();
+    it = std::lower_bound(sorted.begin(), end, key_type(key, 0));
+    for (; it != end && results.size() < max_count; ++it)
+    {
+        if (it->first.compare(0, key.size(), key) != 0)
+            break;
+        if (std::find(results.begin(), results.end(), it->second) == results.end())
+            results.push_back(it->second);
+    }
+
+    return results.size();
+}
+
+void MBookmarkList::Serialize(std::string& data) const
+{
+    // renumber the items without the deleted ones
+    std::vector<BOOKMARK_ID> new_index(m_items.size(), BOOKMARK_ROOT);
+    BOOKMARK_ID count = 0;
+    for (BOOKMARK_ID i = 0; i < m_items.size(); ++i)
+    {
+        if (!m_items[i].m_deleted)
+            new_index[i] = count++;
+    }
+
+    data.assign(s_szMagic, 4);
+    data += char(BOOKMARKS_VERSION);
+    DoWriteVarint(data, count);
+    for (BOOKMARK_ID i = 0; i < m_items.size(); ++i)
+    {
+        const BOOKMARK& item = m_items[i];
+        if (item.m_deleted)
+            continue;
+
+        BOOKMARK_ID parent = BOOKMARK_ROOT;
+        if (item.m_parent != BOOKMARK_ROOT)
+            parent = new_index[item.m_parent];
+        DoWriteVarint(data, (parent == BOOKMARK_ROOT) ? 0 : parent + 1);
+        data += char(item.m_is_folder ? 1 : 0);
+        DoWriteString(data, item.m_title);
+        DoWriteString(data, item.m_url);
+        DoWriteString(data, item.m_tags);
+    }
+}
+
+bool MBookmarkList::Parse(const std::string& data)
+{
+    clear();
+
+    const unsigned char *pb = (const unsigned char *)data.c_str();
+    const unsigned char *end = pb + data.size();
+    if (data.size() < 5 || memcmp(pb, s_szMagic, 4) != 0 || pb[4] != BOOKMARKS_VERSION)
+        return false;
+    pb += 5;
+
+    unsigned long count;
+    if (!DoReadVarint(pb, end, count))
+        return false;
+
+    BOOKMARK item;
+    item.m_deleted = false;
+    for (unsigned long i = 0; i < count; ++i)
+    {
+        unsigned long parent;
+        if (!DoReadVarint(pb, end, parent) || pb >= end)
+            break;
+        item.m_parent = parent ? parent - 1 : BOOKMARK_ROOT;
+        item.m_is_folder = (*pb++ & 1) != 0;
+        if (!DoReadString(pb, end, item.m_title) ||
+            !DoReadString(pb, end, item.m_url) ||
+            !DoReadString(pb, end, item.m_tags))
+        {
+            break;
+        }
+        m_items.push_back(item);
+        DoIndex(BOOKMARK_ID(m_items.size() - 1));
+    }
+
+    return m_items.size() == count;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Netscape bookmark file import
+
+static std::string DoDecodeEntities(const std::string& str)
+{
+    std::string ret;
+    for (size_t i = 0; i < str.size(); ++i)
+    {
+        if (str[i] != '&')
+        {
+            ret += str[i];
+            continue;
+        }
+
+        size_t k = str.find(';', i);
+        if (k == std::string::npos || k - i > 10)
+        {
+            ret += str[i];
+            continue;
+        }
+
+        std::string name = str.substr(i + 1, k - i - 1);
+        if (name == "amp")
+            ret += '&';
+        else if (name == "lt")
+            ret += '<';
+        else if (name == "gt")
+            ret += '>';
+        else if (name == "quot")
+            ret += '"';
+        else if (name == "apos")
+            ret += '\'';
+        else if (name.size() > 1 && name[0] == '#')
+        {
+            unsigned long ch = (name[1] == 'x' || name[1] == 'X') ?
+                strtoul(&name[2], NULL, 16) : strtoul(&name[1], NULL, 10);
+            if (ch > 0x10FFFF || (0xD800 <= ch && ch <= 0xDFFF))
+                ch = 0xFFFD;
+
+            wchar_t sz[2];
+            size_t cch = 1;
+            if (ch >= 0x10000)
+            {
+                ch -= 0x10000;
+                sz[0] = wchar_t(0xD800 + (ch >> 10));
+                sz[1] = wchar_t(0xDC00 + (ch & 0x3FF));
+                cch = 2;
+            }
+            else
+            {
+                sz[0] = wchar_t(ch);
+            }
+
+            std::string utf8;
+            if (ch)
+                EncodeUTF8(sz, cch, utf8);
+            ret += utf8;
+        }
+        else
+        {
+            ret += str.substr(i, k - i + 1);
+        }
+        i = k;
+    }
+    return ret;
+}
+
+static bool DoGetAttr(const std::string& tag, const char *name, std::string& value)
+{
+    value.clear();
+
+    std::string lower = tag;
+    for (size_t i = 0; i < lower.size(); ++i)
+    {
+        if ('A' <= lower[i] && lower[i] <= 'Z')
+            lower[i] += 'a' - 'A';
+    }
+
+    std::string key = " ";
+    key += name;
+    key += "=";
+    size_t k = lower.find(key);
+    if (k == std::string::npos)
+        return false;
+
+    k += key.size();
+    if (k < tag.size() && (tag[k] == '"' || tag[k] == '\''))
+    {
+        char quote = tag[k++];
+        size_t j = tag.find(quote, k);
+        if (j == std::string::npos)
+            j = tag.size();
+        value = tag.substr(k, j - k);
+    }
+    else
+    {
+        size_t j = tag.find_first_of(" \t\r\n", k);
+        if (j == std::string::npos)
+            j = tag.size();
+        value = tag.substr(k, j - k);
+    }
+    return true;
+}
+
+static std::wstring DoDecodeText(const std::string& str)
+{
+    std::string utf8 = DoDecodeEntities(str);
+    return UTF8ToWide(utf8.c_str(), utf8.size());
+}
+
+MBookmarkImporter::MBookmarkImporter(MBookmarkList& list) :
+    m_list(list),
+    m_pending(BOOKMARK_ROOT),
+    m_capture(0),
+    m_in_tag(false),
+    m_quote(0),
+    m_first(true)
+{
+    m_folders.push_back(BOOKMARK_ROOT);
+}
+
+void MBookmarkImporter::DoTag(const std::string& tag)
+{
+    std::string name;
+    for (size_t i = 0; i < tag.size() && name.size() < 8; ++i)
+    {
+        char ch = tag[i];
+        if ('A' <= ch && ch <= 'Z')
+            ch += 'a' - 'A';
+        if (('a' <= ch && ch <= 'z') || ('0' <= ch && ch <= '9') || (ch == '/' && i == 0))
+            name += ch;
+        else
+            break;
+    }
+
+    if (name == "h3")
+    {
+        m_capture = 1;
+        m_text.clear();
+    }
+    else if (name == "/h3" && m_capture == 1)
+    {
+        m_pending = m_list.AddFolder(m_folders.back(), DoDecodeText(m_text));
+        m_capture = 0;
+    }
+    else if (name == "dl")
+    {
+        m_folders.push_back(m_pending != BOOKMARK_ROOT ? m_pending : m_folders.back());
+        m_pending = BOOKMARK_ROOT;
+    }
+    else if (name == "/dl")
+    {
+        if (m_folders.size() > 1)
+            m_folders.pop_back();
+    }
+    else if (name == "a")
+    {
+        DoGetAttr(tag, "href", m_href);
+        DoGetAttr(tag, "tags", m_tags);
+        m_capture = 2;
+        m_text.clear();
+    }
+    else if (name == "/a" && m_capture == 2)
+    {
+        std::wstring url = DoDecodeText(m_href);
+        if (url.size() && !m_list.IsBookmarked(url.c_str()))
+        {
+            m_list.AddBookmark(m_folders.back(), DoDecodeText(m_text), url,
+                               DoDecodeText(m_tags));
+        }
+        m_capture = 0;
+    }
+}
+
+void MBookmarkImporter::Feed(const char *pch, size_t cch)
+{
+    size_t i = 0;
+    if (m_first && cch)
+    {
+        if (cch >= 3 && memcmp(pch, "\xEF\xBB\xBF", 3) == 0)
+            i = 3;
+        m_first = false;
+    }
+
+    for (; i < cch; ++i)
+    {
+        char ch = pch[i];
+        if (!m_in_tag)
+        {
+            if (ch == '<')
+            {
+                m_in_tag = true;
+                m_quote = 0;
+                m_tag.clear();
+            }
+            else if (m_capture && m_text.size() < MAX_IMPORT_TEXT)
+            {
+                if (ch != '\r' && ch != '\n')
+                    m_text += ch;
+            }
+        }
+        else if (m_quote)
+        {
+            if (ch == m_quote)
+                m_quote = 0;
+            if (m_tag.size() < MAX_IMPORT_TAG)
+                m_tag += ch;
+        }
+        else if (ch == '>')
+        {
+            m_in_tag = false;
+            DoTag(m_tag);
+        }
+        else
+        {
+            if (ch == '"' || ch == '\'')
+                m_quote = ch;
+            if (m_tag.size() < MAX_IMPORT_TAG)
+                m_tag += ch;
+        }
+    }
+}
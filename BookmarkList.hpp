@@ -0,0 +1,100 @@
+// BookmarkList.hpp --- the items and the indexes of the bookmarks
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef BOOKMARK_LIST_HPP_
+#define BOOKMARK_LIST_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// NOTE: This file doesn't depend on Win32 API.
+
+typedef unsigned long BOOKMARK_ID;      // the index of an item
+
+#define BOOKMARK_ROOT   0xFFFFFFFF
+
+struct BOOKMARK
+{
+    BOOKMARK_ID m_parent;   // index of the parent folder or BOOKMARK_ROOT
+    bool m_is_folder;
+    bool m_deleted;
+    std::wstring m_title;
+    std::wstring m_url;
+    std::wstring m_tags;    // comma-separated
+};
+
+// The bookmarks with the index by URL and the sorted index for the prefix
+// search. Not thread-safe; the caller locks it.
+class MBookmarkList
+{
+public:
+    typedef std::vector<BOOKMARK> list_type;
+
+    MBookmarkList();
+
+    void clear();
+    size_t size() const;
+    const BOOKMARK& operator[](BOOKMARK_ID index) const;
+
+    BOOKMARK_ID AddFolder(BOOKMARK_ID parent, const std::wstring& title);
+    BOOKMARK_ID AddBookmark(BOOKMARK_ID parent, const std::wstring& title,
+                            const std::wstring& url, const std::wstring& tags = L"");
+    bool Remove(BOOKMARK_ID index);
+
+    // O(1) check by normalized URL. Find returns BOOKMARK_ROOT if none.
+    bool IsBookmarked(const wchar_t *url) const;
+    BOOKMARK_ID Find(const wchar_t *url) const;
+
+    // title/URL prefix search (case-insensitive)
+    size_t Search(const wchar_t *prefix, std::vector<BOOKMARK_ID>& results,
+                  size_t max_count) const;
+
+    // the binary form of Bookmarks.dat: "SBBM", the version, the varint
+    // count and the items. The deleted items are dropped.
+    void Serialize(std::string& data) const;
+    bool Parse(const std::string& data);
+
+    static std::wstring NormalizeURL(const wchar_t *url);
+
+protected:
+    typedef std::pair<std::wstring, BOOKMARK_ID> key_type;
+
+    list_type m_items;
+    std::unordered_map<std::wstring, BOOKMARK_ID> m_url2index;
+    mutable std::vector<key_type> m_sorted;
+    mutable bool m_sorted_dirty;
+
+    void DoIndex(BOOKMARK_ID index);
+    void DoSort() const;
+};
+
+// Imports a Netscape bookmark file (bookmarks.html) given in chunks.
+// It keeps only the current tag and text run, so huge exports are imported
+// in constant memory. The URLs already bookmarked are skipped.
+class MBookmarkImporter
+{
+public:
+    MBookmarkImporter(MBookmarkList& list);
+
+    void Feed(const char *pch, size_t cch);
+
+protected:
+    MBookmarkList& m_list;
+    std::vector<BOOKMARK_ID> m_folders; // open <DL> folders
+    BOOKMARK_ID m_pending;              // the folder of the last <H3>
+    int m_capture;                      // 0: none, 1: <H3>, 2: <A>
+    std::string m_text;
+    std::string m_href;
+    std::string m_tags;
+    std::string m_tag;
+    bool m_in_tag;
+    char m_quote;
+    bool m_first;
+
+    void DoTag(const std::string& tag);
+};
+
+#endif  // ndef BOOKMARK_LIST_HPP_
@@ -0,0 +1,151 @@
+// Bookmarks.cpp --- SimpleBrowser bookmarks
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "Bookmarks.hpp"
+#include <cstdio>
+
+MBookmarks g_bookmarks;
+
+MBookmarks::MBookmarks()
+{
+    InitializeCriticalSection(&m_lock);
+}
+
+MBookmarks::~MBookmarks()
+{
+    DeleteCriticalSection(&m_lock);
+}
+
+void MBookmarks::Lock() const
+{
+    EnterCriticalSection(&m_lock);
+}
+
+void MBookmarks::Unlock() const
+{
+    LeaveCriticalSection(&m_lock);
+}
+
+void MBookmarks::clear()
+{
+    Lock();
+    m_list.clear();
+    Unlock();
+}
+
+size_t MBookmarks::size() const
+{
+    return m_list.size();
+}
+
+const BOOKMARK& MBookmarks::operator[](DWORD index) const
+{
+    return m_list[index];
+}
+
+DWORD MBookmarks::AddFolder(DWORD parent, const std::wstring& title)
+{
+    Lock();
+    DWORD index = m_list.AddFolder(parent, title);
+    Unlock();
+    return index;
+}
+
+DWORD MBookmarks::AddBookmark(DWORD parent, const std::wstring& title,
+                              const std::wstring& url, const std::wstring& tags)
+{
+    Lock();
+    DWORD index = m_list.AddBookmark(parent, title, url, tags);
+    Unlock();
+    return index;
+}
+
+BOOL MBookmarks::Remove(DWORD index)
+{
+    Lock();
+    BOOL bOK = m_list.Remove(index);
+    Unlock();
+    return bOK;
+}
+
+DWORD MBookmarks::Find(const WCHAR *url) const
+{
+    Lock();
+    DWORD index = m_list.Find(url);
+    Unlock();
+    return index;
+}
+
+BOOL MBookmarks::IsBookmarked(const WCHAR *url) const
+{
+    return Find(url) != BOOKMARK_ROOT;
+}
+
+size_t MBookmarks::Search(const WCHAR *prefix, std::vector<BOOKMARK_ID>& results,
+                          size_t max_count) const
+{
+    Lock();
+    size_t count = m_list.Search(prefix, results, max_count);
+    Unlock();
+    return count;
+}
+
+BOOL MBookmarks::Load(LPCWSTR path)
+{
+    std::string data;
+    FILE *fp = _wfopen(path, L"rb");
+    if (fp)
+    {
+        char buf[4096];
+        while (size_t count = fread(buf, 1, sizeof(buf), fp))
+        {
+            data.append(buf, count);
+        }
+        fclose(fp);
+    }
+
+    Lock();
+    BOOL bOK = fp && m_list.Parse(data);
+    if (!fp)
+        m_list.clear();
+    Unlock();
+    return bOK;
+}
+
+BOOL MBookmarks::Save(LPCWSTR path) const
+{
+    std::string data;
+    Lock();
+    m_list.Serialize(data);
+    Unlock();
+
+    FILE *fp = _wfopen(path, L"wb");
+    if (!fp)
+        return FALSE;
+
+    BOOL bOK = (fwrite(data.c_str(), data.size(), 1, fp) == 1);
+    if (fclose(fp) != 0)
+        bOK = FALSE;
+    return bOK;
+}
+
+BOOL MBookmarks::ImportHTML(LPCWSTR path)
+{
+    FILE *fp = _wfopen(path, L"rb");
+    if (!fp)
+        return FALSE;
+
+    Lock();
+    MBookmarkImporter importer(m_list);
+    char buf[4096];
+    while (size_t count = fread(buf, 1, sizeof(buf), fp))
+    {
+        importer.Feed(buf, count);
+    }
+    Unlock();
+
+    fclose(fp);
+    return TRUE;
+}
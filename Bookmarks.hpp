@@ -0,0 +1,56 @@
+// Bookmarks.hpp --- SimpleBrowser bookmarks
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef BOOKMARKS_HPP_
+#define BOOKMARKS_HPP_
+
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+#include <string>
+#include <vector>
+#include "BookmarkList.hpp"
+
+// MBookmarkList with the lock and the files
+class MBookmarks
+{
+public:
+    MBookmarks();
+    ~MBookmarks();
+
+    // The address bar autocompletion searches in its own thread. The
+    // methods lock it; lock it while using the items of Search.
+    void Lock() const;
+    void Unlock() const;
+
+    void clear();
+    size_t size() const;
+    const BOOKMARK& operator[](DWORD index) const;
+
+    DWORD AddFolder(DWORD parent, const std::wstring& title);
+    DWORD AddBookmark(DWORD parent, const std::wstring& title,
+                      const std::wstring& url, const std::wstring& tags = L"");
+    BOOL Remove(DWORD index);
+
+    // O(1) check by normalized URL
+    BOOL IsBookmarked(const WCHAR *url) const;
+    DWORD Find(const WCHAR *url) const;
+
+    // title/URL prefix search (case-insensitive)
+    size_t Search(const WCHAR *prefix, std::vector<BOOKMARK_ID>& results,
+                  size_t max_count) const;
+
+    BOOL Load(LPCWSTR path);
+    BOOL Save(LPCWSTR path) const;
+
+    // Netscape bookmark file (bookmarks.html)
+    BOOL ImportHTML(LPCWSTR path);
+
+protected:
+    MBookmarkList m_list;
+    mutable CRITICAL_SECTION m_lock;
+};
+extern MBookmarks g_bookmarks;
+
+#endif  // ndef BOOKMARKS_HPP_
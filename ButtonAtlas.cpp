@@ -0,0 +1,152 @@
+// ButtonAtlas.cpp --- pre-rendered faces of the owner-draw buttons
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "ButtonAtlas.hpp"
+
+MButtonAtlas g_button_atlas;
+
+bool BUTTON_FACE::operator<(const BUTTON_FACE& other) const
+{
+    if (m_siz.cx != other.m_siz.cx)
+        return m_siz.cx < other.m_siz.cx;
+    if (m_siz.cy != other.m_siz.cy)
+        return m_siz.cy < other.m_siz.cy;
+    if (m_state != other.m_state)
+        return m_state < other.m_state;
+    if (m_color != other.m_color)
+        return m_color < other.m_color;
+    if (m_bgcolor != other.m_bgcolor)
+        return m_bgcolor < other.m_bgcolor;
+    if (m_hFont != other.m_hFont)
+        return m_hFont < other.m_hFont;
+    return m_text < other.m_text;
+}
+
+MButtonAtlas::MButtonAtlas() :
+    m_hdcMem(NULL),
+    m_hbmOld(NULL),
+    m_iSelected(size_t(-1))
+{
+}
+
+MButtonAtlas::~MButtonAtlas()
+{
+    Clear();
+}
+
+void MButtonAtlas::Clear()
+{
+    if (m_hdcMem)
+    {
+        SelectObject(m_hdcMem, m_hbmOld);
+        DeleteDC(m_hdcMem);
+        m_hdcMem = NULL;
+        m_hbmOld = NULL;
+    }
+    m_iSelected = size_t(-1);
+
+    for (size_t i = 0; i < m_pages.size(); ++i)
+    {
+        DeleteObject(m_pages[i].m_hbm);
+    }
+    m_pages.clear();
+    m_cells.clear();
+}
+
+BOOL MButtonAtlas::DoAddPage()
+{
+    BITMAPINFO bi;
+    ZeroMemory(&bi, sizeof(bi));
+    bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bi.bmiHeader.biWidth = BUTTON_ATLAS_WIDTH;
+    bi.bmiHeader.biHeight = -BUTTON_ATLAS_HEIGHT;   // top-down
+    bi.bmiHeader.biPlanes = 1;
+    bi.bmiHeader.biBitCount = 32;
+    bi.bmiHeader.biCompression = BI_RGB;
+
+    void *pvBits;
+    HBITMAP hbm = CreateDIBSection(NULL, &bi, DIB_RGB_COLORS, &pvBits, NULL, 0);
+    if (!hbm)
+        return FALSE;
+
+    PAGE page;
+    page.m_hbm = hbm;
+    page.m_x = page.m_y = page.m_cyShelf = 0;
+    m_pages.push_back(page);
+    return TRUE;
+}
+
+HDC MButtonAtlas::DoSelectPage(size_t iPage)
+{
+    if (!m_hdcMem)
+    {
+        m_hdcMem = CreateCompatibleDC(NULL);
+        if (!m_hdcMem)
+            return NULL;
+        m_hbmOld = SelectObject(m_hdcMem, m_pages[iPage].m_hbm);
+    }
+    else if (m_iSelected != iPage)
+    {
+        SelectObject(m_hdcMem, m_pages[iPage].m_hbm);
+    }
+    m_iSelected = iPage;
+    return m_hdcMem;
+}
+
+BOOL MButtonAtlas::Draw(HDC hdc, INT x, INT y, const BUTTON_FACE& face)
+{
+    std::map<BUTTON_FACE, CELL>::const_iterator it = m_cells.find(face);
+    if (it == m_cells.end())
+        return FALSE;
+
+    const CELL& cell = it->second;
+    HDC hdcMem = DoSelectPage(cell.m_iPage);
+    if (!hdcMem)
+        return FALSE;
+
+    return BitBlt(hdc, x, y, face.m_siz.cx, face.m_siz.cy,
+                  hdcMem, cell.m_pt.x, cell.m_pt.y, SRCCOPY);
+}
+
+HDC MButtonAtlas::Add(const BUTTON_FACE& face, RECT& rcCell)
+{
+    INT cx = face.m_siz.cx, cy = face.m_siz.cy;
+    if (cx <= 0 || cy <= 0 || cx > BUTTON_ATLAS_WIDTH || cy > BUTTON_ATLAS_HEIGHT)
+        return NULL;
+
+    PAGE *pPage = m_pages.empty() ? NULL : &m_pages.back();
+    if (pPage && pPage->m_x + cx > BUTTON_ATLAS_WIDTH)
+    {
+        // the next shelf
+        pPage->m_x = 0;
+        pPage->m_y += pPage->m_cyShelf;
+        pPage->m_cyShelf = 0;
+    }
+    if (!pPage || pPage->m_y + cy > BUTTON_ATLAS_HEIGHT)
+    {
+        // the old faces of the old sizes are dropped at once
+        if (m_pages.size() >= BUTTON_ATLAS_MAX_PAGES)
+            Clear();
+        if (!DoAddPage())
+            return NULL;
+        pPage = &m_pages.back();
+    }
+
+    CELL cell;
+    cell.m_iPage = m_pages.size() - 1;
+    cell.m_pt.x = pPage->m_x;
+    cell.m_pt.y = pPage->m_y;
+
+    HDC hdcMem = DoSelectPage(cell.m_iPage);
+    if (!hdcMem)
+        return NULL;
+
+    pPage->m_x += cx;
+    if (pPage->m_cyShelf < cy)
+        pPage->m_cyShelf = cy;
+    m_cells[face] = cell;
+
+    SetRect(&rcCell, cell.m_pt.x, cell.m_pt.y, cell.m_pt.x + cx, cell.m_pt.y + cy);
+    return hdcMem;
+}
@@ -0,0 +1,84 @@
+// ButtonAtlas.hpp --- pre-rendered faces of the owner-draw buttons
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef BUTTON_ATLAS_HPP_
+#define BUTTON_ATLAS_HPP_
+
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+#include <string>
+#include <vector>
+#include <map>
+
+// the states of a button face
+#define BUTTON_FACE_NORMAL      0
+#define BUTTON_FACE_PRESSED     1
+#define BUTTON_FACE_CHECKED     2
+#define BUTTON_FACE_DISABLED    3
+
+// the size of a page of the atlas
+#define BUTTON_ATLAS_WIDTH      512
+#define BUTTON_ATLAS_HEIGHT     512
+
+// the atlas is cleared when more pages are needed
+#define BUTTON_ATLAS_MAX_PAGES  4
+
+// everything that the appearance of a button depends on
+struct BUTTON_FACE
+{
+    SIZE m_siz;
+    std::wstring m_text;
+    HFONT m_hFont;
+    COLORREF m_color;
+    COLORREF m_bgcolor;
+    UINT m_state;           // BUTTON_FACE_NORMAL etc.
+
+    bool operator<(const BUTTON_FACE& other) const;
+};
+
+// The faces are rendered once into the 32-bpp DIB sections and copied by
+// BitBlt on painting. The pages are packed in rows (shelves).
+class MButtonAtlas
+{
+public:
+    MButtonAtlas();
+    ~MButtonAtlas();
+
+    // copies the face to hdc if it's rendered
+    BOOL Draw(HDC hdc, INT x, INT y, const BUTTON_FACE& face);
+
+    // reserves the space of the face and returns the memory DC to render
+    // it into rcCell. NULL if it's too large.
+    HDC Add(const BUTTON_FACE& face, RECT& rcCell);
+
+    // discards all the faces (e.g. on reloading the side files)
+    void Clear();
+
+protected:
+    struct PAGE
+    {
+        HBITMAP m_hbm;
+        INT m_x;            // the free space in the current shelf
+        INT m_y;            // the top of the current shelf
+        INT m_cyShelf;      // the height of the current shelf
+    };
+    struct CELL
+    {
+        size_t m_iPage;
+        POINT m_pt;
+    };
+
+    std::vector<PAGE> m_pages;
+    std::map<BUTTON_FACE, CELL> m_cells;
+    HDC m_hdcMem;
+    HGDIOBJ m_hbmOld;
+    size_t m_iSelected;     // the page selected into m_hdcMem
+
+    BOOL DoAddPage();
+    HDC DoSelectPage(size_t iPage);
+};
+extern MButtonAtlas g_button_atlas;
+
+#endif  // ndef BUTTON_ATLAS_HPP_
@@ -0,0 +1,339 @@
+// ConfigCache.cpp --- compiled cache of the layout and menu files
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "ConfigCache.hpp"
+#include <strsafe.h>
+#include <cstdio>
+#include <cstring>
+
+MConfigCache g_config_cache;
+
+#define CONFIG_CACHE_VERSION    2
+#define CONFIG_NAME_MAX         64
+
+static const char s_szCacheMagic[] = "SBCC";
+
+// the head of the cache file. The entries and the tables follow it.
+struct CONFIG_CACHE_HEADER
+{
+    char m_magic[4];
+    DWORD m_version;
+    DWORD m_count;
+};
+
+struct CONFIG_CACHE_ENTRY
+{
+    WCHAR m_name[CONFIG_NAME_MAX];
+    WCHAR m_path[MAX_PATH];
+    WCHAR m_missing[CONFIG_PROBE_MAX][MAX_PATH];    // empty if none
+    ULONGLONG m_size;
+    FILETIME m_ftLastWrite;
+    DWORD m_offset;             // the table from the top of the file
+    DWORD m_length;
+};
+
+static BOOL DoGetFileInfo(LPCWSTR path, ULONGLONG& size, FILETIME& ftLastWrite)
+{
+    WIN32_FILE_ATTRIBUTE_DATA attrs;
+    if (!GetFileAttributesExW(path, GetFileExInfoStandard, &attrs))
+        return FALSE;
+
+    size = (ULONGLONG(attrs.nFileSizeHigh) << 32) | attrs.nFileSizeLow;
+    ftLastWrite = attrs.ftLastWriteTime;
+    return TRUE;
+}
+
+// a file probed before the source file has appeared?
+static BOOL DoHasAppeared(const std::vector<std::wstring>& missing)
+{
+    for (size_t i = 0; i < missing.size(); ++i)
+    {
+        if (GetFileAttributesW(missing[i].c_str()) != INVALID_FILE_ATTRIBUTES)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static void DoGetMissing(const CONFIG_CACHE_ENTRY& entry, std::vector<std::wstring>& missing)
+{
+    missing.clear();
+    for (INT i = 0; i < CONFIG_PROBE_MAX; ++i)
+    {
+        WCHAR szPath[MAX_PATH];
+        lstrcpynW(szPath, entry.m_missing[i], MAX_PATH);
+        if (szPath[0])
+            missing.push_back(szPath);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// MConfigCache
+
+MConfigCache::MConfigCache() :
+    m_hFile(INVALID_HANDLE_VALUE),
+    m_hMapping(NULL),
+    m_pb(NULL),
+    m_cb(0)
+{
+    InitializeCriticalSection(&m_lock);
+}
+
+MConfigCache::~MConfigCache()
+{
+    Close();
+    DeleteCriticalSection(&m_lock);
+}
+
+BOOL MConfigCache::Open(const std::wstring& path)
+{
+    Close();
+    m_path = path;
+    m_updated.clear();
+    return DoMap();
+}
+
+BOOL MConfigCache::DoMap()
+{
+    m_hFile = CreateFileW(m_path.c_str(), GENERIC_READ,
+                          FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_hFile == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    DWORD cbHigh = 0;
+    m_cb = GetFileSize(m_hFile, &cbHigh);
+    if (cbHigh == 0 && m_cb >= sizeof(CONFIG_CACHE_HEADER))
+    {
+        m_hMapping = CreateFileMappingW(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (m_hMapping)
+            m_pb = (const BYTE *)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+    }
+
+    const CONFIG_CACHE_HEADER *header = (const CONFIG_CACHE_HEADER *)m_pb;
+    if (!header ||
+        memcmp(header->m_magic, s_szCacheMagic, 4) != 0 ||
+        header->m_version != CONFIG_CACHE_VERSION ||
+        header->m_count > (m_cb - sizeof(*header)) / sizeof(CONFIG_CACHE_ENTRY))
+    {
+        Close();
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void MConfigCache::Close()
+{
+    if (m_pb)
+    {
+        UnmapViewOfFile(m_pb);
+        m_pb = NULL;
+    }
+    if (m_hMapping)
+    {
+        CloseHandle(m_hMapping);
+        m_hMapping = NULL;
+    }
+    if (m_hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_hFile);
+        m_hFile = INVALID_HANDLE_VALUE;
+    }
+    m_cb = 0;
+}
+
+BOOL MConfigCache::Find(LPCWSTR name, MConfigTable& table, std::wstring& path,
+                        std::vector<std::wstring> *pMissing)
+{
+    EnterCriticalSection(&m_lock);
+    BOOL bFound = DoFind(name, table, path, pMissing);
+    LeaveCriticalSection(&m_lock);
+    return bFound;
+}
+
+BOOL MConfigCache::DoFind(LPCWSTR name, MConfigTable& table, std::wstring& path,
+                          std::vector<std::wstring> *pMissing)
+{
+    ULONGLONG size;
+    FILETIME ftLastWrite;
+
+    // updated in this process
+    std::map<std::wstring, ENTRY>::const_iterator it = m_updated.find(name);
+    if (it != m_updated.end())
+    {
+        const ENTRY& entry = it->second;
+        if (!DoGetFileInfo(entry.m_path.c_str(), size, ftLastWrite) ||
+            size != entry.m_size ||
+            CompareFileTime(&ftLastWrite, &entry.m_ftLastWrite) != 0 ||
+            DoHasAppeared(entry.m_missing))
+        {
+            return FALSE;
+        }
+        path = entry.m_path;
+        if (pMissing)
+            *pMissing = entry.m_missing;
+        return table.Attach(entry.m_blob.data(), entry.m_blob.size());
+    }
+
+    if (!m_pb)
+        return FALSE;
+
+    const CONFIG_CACHE_HEADER *header = (const CONFIG_CACHE_HEADER *)m_pb;
+    const CONFIG_CACHE_ENTRY *entries = (const CONFIG_CACHE_ENTRY *)(header + 1);
+    for (DWORD i = 0; i < header->m_count; ++i)
+    {
+        const CONFIG_CACHE_ENTRY& entry = entries[i];
+        if (wcsncmp(entry.m_name, name, CONFIG_NAME_MAX) != 0)
+            continue;
+
+        if (entry.m_offset > m_cb || entry.m_length > m_cb - entry.m_offset)
+            return FALSE;
+
+        WCHAR szPath[MAX_PATH];
+        lstrcpynW(szPath, entry.m_path, MAX_PATH);
+        std::vector<std::wstring> missing;
+        DoGetMissing(entry, missing);
+        if (!DoGetFileInfo(szPath, size, ftLastWrite) ||
+            size != entry.m_size ||
+            CompareFileTime(&ftLastWrite, &entry.m_ftLastWrite) != 0 ||
+            DoHasAppeared(missing))
+        {
+            return FALSE;
+        }
+
+        path = szPath;
+        if (pMissing)
+            pMissing->swap(missing);
+        return table.Attach(m_pb + entry.m_offset, entry.m_length);
+    }
+
+    return FALSE;
+}
+
+void MConfigCache::Update(LPCWSTR name, LPCWSTR path, const std::string& blob,
+                          const std::vector<std::wstring>& missing)
+{
+    ENTRY entry;
+    entry.m_path = path;
+    entry.m_missing = missing;
+    if (entry.m_missing.size() > CONFIG_PROBE_MAX)
+        entry.m_missing.resize(CONFIG_PROBE_MAX);
+    BOOL bOK = DoGetFileInfo(path, entry.m_size, entry.m_ftLastWrite);
+    if (bOK)
+        entry.m_blob = blob;
+
+    EnterCriticalSection(&m_lock);
+    if (bOK)
+        m_updated[name] = entry;
+    else
+        m_updated.erase(name);
+    LeaveCriticalSection(&m_lock);
+}
+
+// Another process may have the file mapped. Then it cannot be replaced,
+// and the updates are kept for the next time.
+BOOL MConfigCache::Save()
+{
+    EnterCriticalSection(&m_lock);
+    if (m_updated.empty() || m_path.empty())
+    {
+        LeaveCriticalSection(&m_lock);
+        return TRUE;
+    }
+
+    // the entries mapped and not updated
+    std::map<std::wstring, ENTRY> entries = m_updated;
+    if (m_pb)
+    {
+        const CONFIG_CACHE_HEADER *header = (const CONFIG_CACHE_HEADER *)m_pb;
+        const CONFIG_CACHE_ENTRY *old = (const CONFIG_CACHE_ENTRY *)(header + 1);
+        for (DWORD i = 0; i < header->m_count; ++i)
+        {
+            WCHAR szName[CONFIG_NAME_MAX];
+            lstrcpynW(szName, old[i].m_name, CONFIG_NAME_MAX);
+            if (entries.count(szName) ||
+                old[i].m_offset > m_cb || old[i].m_length > m_cb - old[i].m_offset)
+            {
+                continue;
+            }
+
+            ENTRY& entry = entries[szName];
+            WCHAR szPath[MAX_PATH];
+            lstrcpynW(szPath, old[i].m_path, MAX_PATH);
+            entry.m_path = szPath;
+            entry.m_size = old[i].m_size;
+            entry.m_ftLastWrite = old[i].m_ftLastWrite;
+            DoGetMissing(old[i], entry.m_missing);
+            entry.m_blob.assign((const char *)m_pb + old[i].m_offset, old[i].m_length);
+        }
+    }
+
+    CONFIG_CACHE_HEADER header;
+    memcpy(header.m_magic, s_szCacheMagic, 4);
+    header.m_version = CONFIG_CACHE_VERSION;
+    header.m_count = DWORD(entries.size());
+
+    std::string file((const char *)&header, sizeof(header));
+    DWORD offset = DWORD(sizeof(header) + entries.size() * sizeof(CONFIG_CACHE_ENTRY));
+    std::map<std::wstring, ENTRY>::const_iterator it;
+    for (it = entries.begin(); it != entries.end(); ++it)
+    {
+        CONFIG_CACHE_ENTRY entry;
+        ZeroMemory(&entry, sizeof(entry));
+        lstrcpynW(entry.m_name, it->first.c_str(), CONFIG_NAME_MAX);
+        lstrcpynW(entry.m_path, it->second.m_path.c_str(), MAX_PATH);
+        entry.m_size = it->second.m_size;
+        entry.m_ftLastWrite = it->second.m_ftLastWrite;
+        for (size_t i = 0; i < it->second.m_missing.size(); ++i)
+        {
+            lstrcpynW(entry.m_missing[i], it->second.m_missing[i].c_str(), MAX_PATH);
+        }
+        entry.m_offset = offset;
+        entry.m_length = DWORD(it->second.m_blob.size());
+        file.append((const char *)&entry, sizeof(entry));
+        offset += entry.m_length;
+    }
+    for (it = entries.begin(); it != entries.end(); ++it)
+    {
+        file += it->second.m_blob;
+    }
+
+    // the mapped file cannot be replaced
+    Close();
+
+    // each process has its own temporary file
+    WCHAR szSuffix[32];
+    StringCbPrintfW(szSuffix, sizeof(szSuffix), L".%lu.tmp", GetCurrentProcessId());
+    std::wstring temp = m_path + szSuffix;
+
+    FILE *fp = _wfopen(temp.c_str(), L"wb");
+    BOOL bOK = FALSE;
+    if (fp)
+    {
+        bOK = (fwrite(file.c_str(), file.size(), 1, fp) == 1);
+        if (fclose(fp) != 0)
+            bOK = FALSE;
+        if (bOK)
+        {
+            if (MoveFileExW(temp.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING))
+            {
+                m_updated.clear();
+            }
+            else
+            {
+                printf("MConfigCache::Save: in use (%lu)\n", GetLastError());
+                DeleteFileW(temp.c_str());
+            }
+        }
+        else
+        {
+            DeleteFileW(temp.c_str());
+        }
+    }
+
+    DoMap();
+    LeaveCriticalSection(&m_lock);
+    return bOK;
+}
@@ -0,0 +1,70 @@
+// ConfigCache.hpp --- compiled cache of the layout and menu files
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef CONFIG_CACHE_HPP_
+#define CONFIG_CACHE_HPP_
+
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+#include <string>
+#include <vector>
+#include <map>
+#include "ConfigTable.hpp"
+
+// the maximum number of the paths probed before the source file
+#define CONFIG_PROBE_MAX    2
+
+// the compiled tables of the config files in one file.
+// The file is mapped into memory, and each table is valid only while its
+// source file has the same path, size and last write time, and none of the
+// paths probed before it has appeared.
+// Find and Update can be called from the worker threads.
+class MConfigCache
+{
+public:
+    MConfigCache();
+    ~MConfigCache();
+
+    BOOL Open(const std::wstring& path);
+    void Close();
+
+    // finds the valid table of the config file (e.g. L"Upside_en.txt").
+    // pMissing receives the paths probed before path.
+    BOOL Find(LPCWSTR name, MConfigTable& table, std::wstring& path,
+              std::vector<std::wstring> *pMissing = NULL);
+
+    // replaces the table compiled from the source file.
+    // missing is the paths probed before path that didn't exist.
+    void Update(LPCWSTR name, LPCWSTR path, const std::string& blob,
+                const std::vector<std::wstring>& missing);
+
+    // writes the file if updated
+    BOOL Save();
+
+protected:
+    struct ENTRY
+    {
+        std::wstring m_path;
+        ULONGLONG m_size;
+        FILETIME m_ftLastWrite;
+        std::vector<std::wstring> m_missing;
+        std::string m_blob;
+    };
+
+    std::wstring m_path;
+    HANDLE m_hFile;
+    HANDLE m_hMapping;
+    const BYTE *m_pb;
+    DWORD m_cb;
+    std::map<std::wstring, ENTRY> m_updated;
+    CRITICAL_SECTION m_lock;
+
+    BOOL DoMap();
+    BOOL DoFind(LPCWSTR name, MConfigTable& table, std::wstring& path,
+                 std::vector<std::wstring> *pMissing);
+};
+extern MConfigCache g_config_cache;
+
+#endif  // ndef CONFIG_CACHE_HPP_
@@ -0,0 +1,134 @@
+// ConfigTable.cpp --- compiled table of the layout and menu files
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "ConfigTable.hpp"
+#include "ConfigTokenizer.hpp"
+#include <cstring>
+#include <vector>
+
+// NOTE: This file doesn't depend on Win32 API.
+
+MConfigTable::MConfigTable() : m_pb(NULL), m_rows(NULL), m_fields(NULL), m_nRows(0)
+{
+}
+
+bool MConfigTable::Attach(const void *pv, size_t cb)
+{
+    m_pb = NULL;
+    m_rows = m_fields = NULL;
+    m_nRows = 0;
+
+    const unsigned char *pb = (const unsigned char *)pv;
+    if (!pb || cb < sizeof(CONFIG_TABLE_HEADER) || (cb & 3) != 0 || (size_t(pb) & 3) != 0)
+        return false;
+
+    const CONFIG_TABLE_HEADER *header = (const CONFIG_TABLE_HEADER *)pb;
+    size_t nRows = header->m_rows, nFields = header->m_fields;
+    if (nRows >= cb / sizeof(uint32_t) || nFields >= cb / sizeof(uint32_t))
+        return false;
+
+    size_t ibPool = sizeof(CONFIG_TABLE_HEADER) + (nRows + 1 + nFields) * sizeof(uint32_t);
+    if (ibPool + sizeof(CONFIG_CHAR) > cb)
+        return false;
+
+    // the last character terminates any string
+    if (*(const CONFIG_CHAR *)(pb + cb - sizeof(CONFIG_CHAR)) != 0)
+        return false;
+
+    const uint32_t *rows = (const uint32_t *)(header + 1);
+    const uint32_t *fields = rows + nRows + 1;
+    if (rows[0] != 0 || rows[nRows] != nFields)
+        return false;
+    for (size_t i = 0; i < nRows; ++i)
+    {
+        if (rows[i] > rows[i + 1])
+            return false;
+    }
+    for (size_t i = 0; i < nFields; ++i)
+    {
+        if (fields[i] < ibPool || fields[i] >= cb || (fields[i] & 1) != 0)
+            return false;
+    }
+
+    m_pb = pb;
+    m_rows = rows;
+    m_fields = fields;
+    m_nRows = uint32_t(nRows);
+    return true;
+}
+
+size_t MConfigTable::GetRowCount() const
+{
+    return m_nRows;
+}
+
+size_t MConfigTable::GetFieldCount(size_t iRow) const
+{
+    if (iRow >= m_nRows)
+        return 0;
+    return m_rows[iRow + 1] - m_rows[iRow];
+}
+
+const CONFIG_CHAR *MConfigTable::GetField(size_t iRow, size_t iField) const
+{
+    static const CONFIG_CHAR s_empty[1] = { 0 };
+    if (iField >= GetFieldCount(iRow))
+        return s_empty;
+    return (const CONFIG_CHAR *)(m_pb + m_fields[m_rows[iRow] + iField]);
+}
+
+/*static*/ void MConfigTable::Compile(const char *pch, size_t cch, std::string& blob)
+{
+    std::vector<uint32_t> rows;
+    std::vector<CONFIG_FIELD> fields, row;
+
+    MConfigTokenizer tokenizer(pch, cch);
+    rows.push_back(0);
+    size_t cchMax = 0;
+    while (tokenizer.NextRow(row))
+    {
+        fields.insert(fields.end(), row.begin(), row.end());
+        rows.push_back(uint32_t(fields.size()));
+        for (size_t i = 0; i < row.size(); ++i)
+        {
+            if (cchMax < row[i].m_len)
+                cchMax = row[i].m_len;
+        }
+    }
+
+    CONFIG_TABLE_HEADER header;
+    header.m_rows = uint32_t(rows.size() - 1);
+    header.m_fields = uint32_t(fields.size());
+
+    // the UTF-16 text is not longer than the UTF-8 text
+    size_t ibPool = sizeof(header) + (rows.size() + fields.size()) * sizeof(uint32_t);
+    size_t cbMax = ibPool + sizeof(CONFIG_CHAR);
+    for (size_t i = 0; i < fields.size(); ++i)
+        cbMax += (fields[i].m_len + 1) * sizeof(CONFIG_CHAR);
+    blob.assign(cbMax + 3, 0);
+
+    // DecodeUTF8 writes wchar_t, which may be 32-bit
+    std::vector<wchar_t> units(cchMax + 1);
+
+    char *pb = &blob[0];
+    size_t ibOffsets = sizeof(header) + rows.size() * sizeof(uint32_t);
+    size_t ib = ibPool;
+    for (size_t i = 0; i < fields.size(); ++i)
+    {
+        uint32_t offset = uint32_t(ib);
+        std::memcpy(pb + ibOffsets + i * sizeof(uint32_t), &offset, sizeof(offset));
+
+        size_t cchField = DecodeUTF8(fields[i].m_ptr, fields[i].m_len, &units[0]);
+        CONFIG_CHAR *pch = (CONFIG_CHAR *)(pb + ib);
+        for (size_t k = 0; k < cchField; ++k)
+            pch[k] = CONFIG_CHAR(units[k]);
+        ib += (cchField + 1) * sizeof(CONFIG_CHAR);
+    }
+    ib += sizeof(CONFIG_CHAR);  // the terminator
+    ib = (ib + 3) & ~size_t(3);
+
+    std::memcpy(pb, &header, sizeof(header));
+    std::memcpy(pb + sizeof(header), &rows[0], rows.size() * sizeof(uint32_t));
+    blob.resize(ib);
+}
@@ -0,0 +1,56 @@
+// ConfigTable.hpp --- compiled table of the layout and menu files
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef CONFIG_TABLE_HPP_
+#define CONFIG_TABLE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// NOTE: This file doesn't depend on Win32 API.
+
+// a UTF-16 code unit of the strings. It's WCHAR on Windows.
+#ifdef _WIN32
+    typedef wchar_t CONFIG_CHAR;
+#else
+    typedef char16_t CONFIG_CHAR;
+#endif
+
+// The rows of tab-separated fields in a relocatable binary form:
+//   CONFIG_TABLE_HEADER
+//   uint32_t rows[m_rows + 1];     the index of the first field of each row
+//   uint32_t fields[m_fields];     the byte offset of each field string
+//   CONFIG_CHAR strings[];         null-terminated
+// The size is a multiple of 4.
+struct CONFIG_TABLE_HEADER
+{
+    uint32_t m_rows;
+    uint32_t m_fields;
+};
+
+// a read-only view of a compiled table. The strings are used in place.
+class MConfigTable
+{
+public:
+    MConfigTable();
+
+    // checks the bounds of the table. pv is aligned to 4 bytes.
+    bool Attach(const void *pv, size_t cb);
+
+    size_t GetRowCount() const;
+    size_t GetFieldCount(size_t iRow) const;
+    const CONFIG_CHAR *GetField(size_t iRow, size_t iField) const;  // empty if none
+
+    // the UTF-8 text of the side or menu file --> a compiled table
+    static void Compile(const char *pch, size_t cch, std::string& blob);
+
+protected:
+    const unsigned char *m_pb;
+    const uint32_t *m_rows;
+    const uint32_t *m_fields;
+    uint32_t m_nRows;
+};
+
+#endif  // ndef CONFIG_TABLE_HPP_
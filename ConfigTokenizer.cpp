@@ -0,0 +1,66 @@
+// ConfigTokenizer.cpp --- tokenizer of the side and menu files
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "ConfigTokenizer.hpp"
+#include <cstring>
+
+static inline bool IsSpace(char ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == '\f' || ch == '\v';
+}
+
+MConfigTokenizer::MConfigTokenizer(const char *pch, size_t cch)
+    : m_pch(pch), m_end(pch + cch)
+{
+    if (cch >= 3 && memcmp(pch, "\xEF\xBB\xBF", 3) == 0)
+        m_pch += 3;
+}
+
+bool MConfigTokenizer::NextRow(std::vector<CONFIG_FIELD>& fields)
+{
+    while (m_pch < m_end)
+    {
+        const char *line = m_pch;
+        const char *eol = (const char *)memchr(line, '\n', m_end - line);
+        if (eol)
+            m_pch = eol + 1;
+        else
+            m_pch = eol = m_end;
+
+        const char *end = (const char *)memchr(line, ';', eol - line);
+        if (!end)
+            end = eol;
+
+        while (line < end && IsSpace(*line))
+            ++line;
+        while (line < end && IsSpace(end[-1]))
+            --end;
+
+        fields.clear();
+        for (const char *pch = line; ; )
+        {
+            const char *tab = (const char *)memchr(pch, '\t', end - pch);
+            if (!tab)
+                tab = end;
+
+            CONFIG_FIELD field = { pch, size_t(tab - pch) };
+            while (field.m_len && IsSpace(*field.m_ptr))
+            {
+                ++field.m_ptr;
+                --field.m_len;
+            }
+            while (field.m_len && IsSpace(field.m_ptr[field.m_len - 1]))
+                --field.m_len;
+            fields.push_back(field);
+
+            if (tab == end)
+                break;
+            pch = tab + 1;
+        }
+
+        if (fields.size() >= 2)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,39 @@
+// ConfigTokenizer.hpp --- tokenizer of the side and menu files
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef CONFIG_TOKENIZER_HPP_
+#define CONFIG_TOKENIZER_HPP_
+
+#include <cstddef>
+#include <vector>
+#include "UTF8Codec.hpp"
+
+// NOTE: This file doesn't depend on Win32 API.
+
+// a field in the UTF-8 buffer (not null-terminated)
+struct CONFIG_FIELD
+{
+    const char *m_ptr;
+    size_t m_len;
+};
+
+// Splits the UTF-8 text in one pass without copying:
+// - the UTF-8 BOM is skipped
+// - ';' comments out the rest of the line
+// - the fields are separated by tabs and trimmed
+// - the lines of less than two fields are skipped
+class MConfigTokenizer
+{
+public:
+    MConfigTokenizer(const char *pch, size_t cch);
+
+    // returns false at the end
+    bool NextRow(std::vector<CONFIG_FIELD>& fields);
+
+protected:
+    const char *m_pch;
+    const char *m_end;
+};
+
+#endif  // ndef CONFIG_TOKENIZER_HPP_
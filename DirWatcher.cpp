@@ -0,0 +1,177 @@
+// DirWatcher.cpp --- watching the changes of the files in a directory
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "DirWatcher.hpp"
+#include <windows.h>
+#include <process.h>
+#include <algorithm>
+
+// ReadDirectoryChangesW in a worker thread
+class MDirWatcherWin32 : public MDirWatcher
+{
+public:
+    MDirWatcherWin32(DIR_WATCHER_PROC fnNotify, void *context);
+    virtual ~MDirWatcherWin32();
+
+    virtual bool Start(const std::wstring& dir);
+    virtual void Stop();
+    virtual void TakeChanges(std::vector<std::wstring>& names);
+
+protected:
+    DIR_WATCHER_PROC m_fnNotify;
+    void *m_context;
+    HANDLE m_hDir;
+    HANDLE m_hQuit;
+    HANDLE m_hThread;
+    CRITICAL_SECTION m_lock;
+    std::vector<std::wstring> m_changes;
+
+    void DoAddChange(const std::wstring& name);
+    static unsigned __stdcall WatcherProc(void *arg);
+};
+
+/*static*/ MDirWatcher *MDirWatcher::Create(DIR_WATCHER_PROC fnNotify, void *context)
+{
+    return new MDirWatcherWin32(fnNotify, context);
+}
+
+MDirWatcherWin32::MDirWatcherWin32(DIR_WATCHER_PROC fnNotify, void *context) :
+    m_fnNotify(fnNotify),
+    m_context(context),
+    m_hDir(INVALID_HANDLE_VALUE),
+    m_hQuit(NULL),
+    m_hThread(NULL)
+{
+    InitializeCriticalSection(&m_lock);
+}
+
+MDirWatcherWin32::~MDirWatcherWin32()
+{
+    Stop();
+    DeleteCriticalSection(&m_lock);
+}
+
+bool MDirWatcherWin32::Start(const std::wstring& dir)
+{
+    Stop();
+
+    m_hDir = CreateFileW(dir.c_str(), FILE_LIST_DIRECTORY,
+                         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                         NULL, OPEN_EXISTING,
+                         FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (m_hDir == INVALID_HANDLE_VALUE)
+        return false;
+
+    m_hQuit = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (m_hQuit)
+        m_hThread = (HANDLE)_beginthreadex(NULL, 0, WatcherProc, this, 0, NULL);
+    if (!m_hThread)
+    {
+        Stop();
+        return false;
+    }
+
+    return true;
+}
+
+void MDirWatcherWin32::Stop()
+{
+    if (m_hThread)
+    {
+        SetEvent(m_hQuit);
+        WaitForSingleObject(m_hThread, INFINITE);
+        CloseHandle(m_hThread);
+        m_hThread = NULL;
+    }
+    if (m_hQuit)
+    {
+        CloseHandle(m_hQuit);
+        m_hQuit = NULL;
+    }
+    if (m_hDir != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_hDir);
+        m_hDir = INVALID_HANDLE_VALUE;
+    }
+}
+
+void MDirWatcherWin32::TakeChanges(std::vector<std::wstring>& names)
+{
+    names.clear();
+    EnterCriticalSection(&m_lock);
+    names.swap(m_changes);
+    LeaveCriticalSection(&m_lock);
+}
+
+void MDirWatcherWin32::DoAddChange(const std::wstring& name)
+{
+    EnterCriticalSection(&m_lock);
+    BOOL bWasEmpty = m_changes.empty();
+    if (std::find(m_changes.begin(), m_changes.end(), name) == m_changes.end())
+        m_changes.push_back(name);
+    LeaveCriticalSection(&m_lock);
+
+    if (bWasEmpty)
+        m_fnNotify(m_context);
+}
+
+/*static*/ unsigned __stdcall MDirWatcherWin32::WatcherProc(void *arg)
+{
+    MDirWatcherWin32 *pThis = (MDirWatcherWin32 *)arg;
+
+    OVERLAPPED ov;
+    ZeroMemory(&ov, sizeof(ov));
+    ov.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!ov.hEvent)
+        return 0;
+
+    DWORD adwBuffer[1024];     // DWORD-aligned
+    const DWORD dwFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE |
+                           FILE_NOTIFY_CHANGE_LAST_WRITE;
+    for (;;)
+    {
+        ResetEvent(ov.hEvent);
+        if (!ReadDirectoryChangesW(pThis->m_hDir, adwBuffer, sizeof(adwBuffer), FALSE,
+                                   dwFilter, NULL, &ov, NULL))
+        {
+            break;
+        }
+
+        HANDLE ahEvents[2] = { pThis->m_hQuit, ov.hEvent };
+        DWORD dwWait = WaitForMultipleObjects(2, ahEvents, FALSE, INFINITE);
+        if (dwWait != WAIT_OBJECT_0 + 1)
+        {
+            CancelIo(pThis->m_hDir);
+            DWORD cbDummy;
+            GetOverlappedResult(pThis->m_hDir, &ov, &cbDummy, TRUE);
+            break;
+        }
+
+        DWORD cbRead = 0;
+        if (!GetOverlappedResult(pThis->m_hDir, &ov, &cbRead, FALSE))
+            break;
+
+        if (cbRead == 0)
+        {
+            // the buffer overflowed
+            pThis->DoAddChange(std::wstring());
+            continue;
+        }
+
+        const BYTE *pb = (const BYTE *)adwBuffer;
+        for (;;)
+        {
+            const FILE_NOTIFY_INFORMATION *info = (const FILE_NOTIFY_INFORMATION *)pb;
+            std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+            pThis->DoAddChange(name);
+
+            if (info->NextEntryOffset == 0)
+                break;
+            pb += info->NextEntryOffset;
+        }
+    }
+
+    CloseHandle(ov.hEvent);
+    return 0;
+}
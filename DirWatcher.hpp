@@ -0,0 +1,33 @@
+// DirWatcher.hpp --- watching the changes of the files in a directory
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef DIR_WATCHER_HPP_
+#define DIR_WATCHER_HPP_
+
+#include <string>
+#include <vector>
+
+// NOTE: This file doesn't depend on Win32 API.
+
+// called in the worker thread when the queue becomes non-empty
+typedef void (*DIR_WATCHER_PROC)(void *context);
+
+// The changed file names are queued, and fnNotify is called when the queue
+// becomes non-empty.
+// An empty name means that the changes were lost (reload everything).
+class MDirWatcher
+{
+public:
+    static MDirWatcher *Create(DIR_WATCHER_PROC fnNotify, void *context);
+    virtual ~MDirWatcher() { }
+
+    // not recursive
+    virtual bool Start(const std::wstring& dir) = 0;
+    virtual void Stop() = 0;
+
+    // takes the names of the changed files
+    virtual void TakeChanges(std::vector<std::wstring>& names) = 0;
+};
+
+#endif  // ndef DIR_WATCHER_HPP_
@@ -0,0 +1,186 @@
+// DownloadPart.cpp --- the state of a partial download
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "DownloadPart.hpp"
+#include <cstdio>
+#include <cstring>
+
+#define DOWNLOAD_PART_MAGIC     "SimpleBrowser-Part 1"
+
+static bool DoReadNumber(const char *& pch, SEGMENT_POS& value)
+{
+    if (*pch < '0' || '9' < *pch)
+        return false;
+
+    value = 0;
+    for (; '0' <= *pch && *pch <= '9'; ++pch)
+    {
+        SEGMENT_POS digit = SEGMENT_POS(*pch - '0');
+        if (value > (SEGMENT_POS(-1) - digit) / 10)
+            return false;
+        value = value * 10 + digit;
+    }
+    return true;
+}
+
+DOWNLOAD_PART::DOWNLOAD_PART() : m_total(0)
+{
+}
+
+const std::string& DOWNLOAD_PART::GetValidator() const
+{
+    // an ETag is stronger than a date
+    if (m_etag.size())
+        return m_etag;
+    return m_last_modified;
+}
+
+bool DOWNLOAD_PART::Matches(const DOWNLOAD_PART& part) const
+{
+    // no validator, no guarantee
+    if (GetValidator().empty())
+        return false;
+
+    return m_url == part.m_url &&
+           m_etag == part.m_etag &&
+           m_last_modified == part.m_last_modified &&
+           m_total == part.m_total;
+}
+
+std::string DOWNLOAD_PART::Serialize() const
+{
+    std::string text = DOWNLOAD_PART_MAGIC "\n";
+    text += "URL " + m_url + "\n";
+    if (m_etag.size())
+        text += "ETag " + m_etag + "\n";
+    if (m_last_modified.size())
+        text += "Last-Modified " + m_last_modified + "\n";
+
+    char buf[64];
+    sprintf(buf, "Total %llu\n", m_total);
+    text += buf;
+    for (size_t i = 0; i < m_missing.size(); ++i)
+    {
+        const DOWNLOAD_SEGMENT& segment = m_missing[i];
+        if (segment.m_begin >= segment.m_end)
+            continue;
+        sprintf(buf, "Missing %llu %llu\n", segment.m_begin, segment.m_end);
+        text += buf;
+    }
+    text += "End\n";
+    return text;
+}
+
+bool DOWNLOAD_PART::Parse(const std::string& text)
+{
+    *this = DOWNLOAD_PART();
+
+    bool bMagic = false, bEnd = false;
+    size_t pos = 0;
+    while (pos < text.size() && !bEnd)
+    {
+        size_t next = text.find('\n', pos);
+        if (next == std::string::npos)
+            next = text.size();
+        std::string line = text.substr(pos, next - pos);
+        pos = next + 1;
+
+        if (line.size() && line[line.size() - 1] == '\r')
+            line.resize(line.size() - 1);
+
+        if (!bMagic)
+        {
+            if (line != DOWNLOAD_PART_MAGIC)
+                return false;
+            bMagic = true;
+            continue;
+        }
+
+        if (line == "End")
+        {
+            bEnd = true;
+            continue;
+        }
+
+        size_t space = line.find(' ');
+        if (space == std::string::npos)
+            continue;
+        std::string name = line.substr(0, space);
+        std::string value = line.substr(space + 1);
+        const char *pch = value.c_str();
+
+        if (name == "URL")
+        {
+            m_url = value;
+        }
+        else if (name == "ETag")
+        {
+            m_etag = value;
+        }
+        else if (name == "Last-Modified")
+        {
+            m_last_modified = value;
+        }
+        else if (name == "Total")
+        {
+            if (!DoReadNumber(pch, m_total) || *pch)
+                return false;
+        }
+        else if (name == "Missing")
+        {
+            // the range is treated as written if it's dropped, so a bad
+            // one fails. "Total" comes first.
+            DOWNLOAD_SEGMENT segment;
+            segment.m_active = false;
+            segment.m_writing = 0;
+            if (!DoReadNumber(pch, segment.m_begin) || *pch++ != ' ' ||
+                !DoReadNumber(pch, segment.m_end) || *pch ||
+                segment.m_begin >= segment.m_end || segment.m_end > m_total)
+            {
+                return false;
+            }
+            m_missing.push_back(segment);
+        }
+    }
+
+    // a truncated sidecar could have lost a missing range
+    return bEnd && m_url.size() && m_total > 0;
+}
+
+bool ParseContentRange(const std::string& text, SEGMENT_POS& first,
+                       SEGMENT_POS& last, SEGMENT_POS& total)
+{
+    const char *pch = text.c_str();
+    while (*pch == ' ')
+        ++pch;
+    if (std::strncmp(pch, "bytes ", 6) != 0)
+        return false;
+    pch += 6;
+    while (*pch == ' ')
+        ++pch;
+
+    if (!DoReadNumber(pch, first) || *pch != '-')
+        return false;
+    ++pch;
+    if (!DoReadNumber(pch, last) || *pch != '/')
+        return false;
+    ++pch;
+
+    if (*pch == '*')
+    {
+        total = 0;
+        ++pch;
+    }
+    else if (!DoReadNumber(pch, total))
+    {
+        return false;
+    }
+
+    while (*pch == ' ')
+        ++pch;
+    if (*pch)
+        return false;
+
+    return first <= last && (total == 0 || last < total);
+}
@@ -0,0 +1,57 @@
+// DownloadPart.hpp --- the state of a partial download
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef DOWNLOAD_PART_HPP_
+#define DOWNLOAD_PART_HPP_
+
+#include <string>
+#include <vector>
+#include "SegmentPlanner.hpp"
+
+// NOTE: This file doesn't depend on Win32 API.
+
+// the suffixes of the partial file and its sidecar
+#define DOWNLOAD_PART_SUFFIX        L".part"
+#define DOWNLOAD_SIDECAR_SUFFIX     L".part.txt"
+
+// The sidecar of a ".part" file. The strings are UTF-8. The text is:
+//
+//     SimpleBrowser-Part 1
+//     URL http://...
+//     ETag "..."
+//     Last-Modified Mon, 01 Jan 2019 00:00:00 GMT
+//     Total 123456
+//     Missing 1000 2000
+//     End
+//
+// "Missing" lines are the ranges [begin, end) not written yet.
+// The rest of the file is complete. "End" marks that no line is lost.
+struct DOWNLOAD_PART
+{
+    std::string m_url;
+    std::string m_etag;
+    std::string m_last_modified;
+    SEGMENT_POS m_total;
+    std::vector<DOWNLOAD_SEGMENT> m_missing;
+
+    DOWNLOAD_PART();
+
+    // the value of "If-Range". Empty if no validator.
+    const std::string& GetValidator() const;
+
+    // the same file on the server?
+    bool Matches(const DOWNLOAD_PART& part) const;
+
+    // Parse fails without "End" or on a bad number, because a dropped
+    // "Missing" line would make its range look written.
+    std::string Serialize() const;
+    bool Parse(const std::string& text);
+};
+
+// parses "bytes <first>-<last>/<total>" of "Content-Range". total is
+// zero if it's "*". Returns false if it's not a valid byte range.
+bool ParseContentRange(const std::string& text, SEGMENT_POS& first,
+                       SEGMENT_POS& last, SEGMENT_POS& total);
+
+#endif  // ndef DOWNLOAD_PART_HPP_
@@ -0,0 +1,112 @@
+// DownloadQueue.cpp --- the scheduling of the downloads
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "DownloadQueue.hpp"
+
+MDownloadQueue::MDownloadQueue(size_t max_running) :
+    m_max_running(max_running ? max_running : 1),
+    m_running(0),
+    m_next_id(1)
+{
+}
+
+size_t MDownloadQueue::GetMaxRunning() const
+{
+    return m_max_running;
+}
+
+void MDownloadQueue::SetMaxRunning(size_t max_running)
+{
+    // the running jobs keep running if it's decreased
+    m_max_running = max_running ? max_running : 1;
+}
+
+DOWNLOAD_ID MDownloadQueue::Add(void *context, int priority)
+{
+    DOWNLOAD_ID id = m_next_id++;
+    if (m_next_id == 0)
+        m_next_id = 1;
+
+    JOB& job = m_jobs[id];
+    job.m_context = context;
+    job.m_priority = priority;
+    job.m_state = DOWNLOAD_QUEUED;
+    m_queue.insert(key_type(-priority, id));
+    return id;
+}
+
+DOWNLOAD_ID MDownloadQueue::Start(void **pcontext)
+{
+    if (m_running >= m_max_running || m_queue.empty())
+        return 0;
+
+    DOWNLOAD_ID id = m_queue.begin()->second;
+    m_queue.erase(m_queue.begin());
+
+    JOB& job = m_jobs[id];
+    job.m_state = DOWNLOAD_RUNNING;
+    ++m_running;
+
+    if (pcontext)
+        *pcontext = job.m_context;
+    return id;
+}
+
+void MDownloadQueue::Finish(DOWNLOAD_ID id)
+{
+    std::map<DOWNLOAD_ID, JOB>::iterator it = m_jobs.find(id);
+    if (it == m_jobs.end() || it->second.m_state != DOWNLOAD_RUNNING)
+        return;
+
+    it->second.m_state = DOWNLOAD_DONE;
+    --m_running;
+}
+
+bool MDownloadQueue::Cancel(DOWNLOAD_ID id)
+{
+    std::map<DOWNLOAD_ID, JOB>::iterator it = m_jobs.find(id);
+    if (it == m_jobs.end() || it->second.m_state != DOWNLOAD_QUEUED)
+        return false;
+
+    m_queue.erase(key_type(-it->second.m_priority, id));
+    it->second.m_state = DOWNLOAD_CANCELLED;
+    return true;
+}
+
+void MDownloadQueue::Remove(DOWNLOAD_ID id)
+{
+    std::map<DOWNLOAD_ID, JOB>::iterator it = m_jobs.find(id);
+    if (it == m_jobs.end() || it->second.m_state == DOWNLOAD_RUNNING)
+        return;
+
+    if (it->second.m_state == DOWNLOAD_QUEUED)
+        m_queue.erase(key_type(-it->second.m_priority, id));
+    m_jobs.erase(it);
+}
+
+DOWNLOAD_STATE MDownloadQueue::GetState(DOWNLOAD_ID id) const
+{
+    std::map<DOWNLOAD_ID, JOB>::const_iterator it = m_jobs.find(id);
+    if (it == m_jobs.end())
+        return DOWNLOAD_NONE;
+    return it->second.m_state;
+}
+
+void *MDownloadQueue::GetContext(DOWNLOAD_ID id) const
+{
+    std::map<DOWNLOAD_ID, JOB>::const_iterator it = m_jobs.find(id);
+    if (it == m_jobs.end())
+        return NULL;
+    return it->second.m_context;
+}
+
+size_t MDownloadQueue::GetQueuedCount() const
+{
+    return m_queue.size();
+}
+
+size_t MDownloadQueue::GetRunningCount() const
+{
+    return m_running;
+}
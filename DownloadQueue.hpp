@@ -0,0 +1,73 @@
+// DownloadQueue.hpp --- the scheduling of the downloads
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef DOWNLOAD_QUEUE_HPP_
+#define DOWNLOAD_QUEUE_HPP_
+
+#include <cstddef>
+#include <map>
+#include <set>
+
+// NOTE: This file doesn't depend on Win32 API.
+
+enum DOWNLOAD_STATE
+{
+    DOWNLOAD_NONE,          // no such job
+    DOWNLOAD_QUEUED,
+    DOWNLOAD_RUNNING,
+    DOWNLOAD_DONE,
+    DOWNLOAD_CANCELLED      // cancelled before running
+};
+
+typedef unsigned long DOWNLOAD_ID;      // zero is invalid
+
+// The jobs of higher priority start first, and the jobs of the same
+// priority start in the order of addition. At most GetMaxRunning() jobs
+// are running. Not thread-safe; the caller locks it.
+class MDownloadQueue
+{
+public:
+    MDownloadQueue(size_t max_running = 1);
+
+    size_t GetMaxRunning() const;
+    void SetMaxRunning(size_t max_running);
+
+    DOWNLOAD_ID Add(void *context, int priority = 0);
+
+    // the next job to run, or zero if none or too many are running.
+    // The job becomes DOWNLOAD_RUNNING.
+    DOWNLOAD_ID Start(void **pcontext = NULL);
+
+    // a running job has finished (succeeded or not)
+    void Finish(DOWNLOAD_ID id);
+
+    // cancels a queued job. Returns false if it's already running or done.
+    bool Cancel(DOWNLOAD_ID id);
+
+    // forgets a job not running
+    void Remove(DOWNLOAD_ID id);
+
+    DOWNLOAD_STATE GetState(DOWNLOAD_ID id) const;
+    void *GetContext(DOWNLOAD_ID id) const;
+    size_t GetQueuedCount() const;
+    size_t GetRunningCount() const;
+
+protected:
+    struct JOB
+    {
+        void *m_context;
+        int m_priority;
+        DOWNLOAD_STATE m_state;
+    };
+    // (-priority, id): the first one is the next
+    typedef std::pair<int, DOWNLOAD_ID> key_type;
+
+    std::map<DOWNLOAD_ID, JOB> m_jobs;
+    std::set<key_type> m_queue;
+    size_t m_max_running;
+    size_t m_running;
+    DOWNLOAD_ID m_next_id;
+};
+
+#endif  // ndef DOWNLOAD_QUEUE_HPP_
@@ -0,0 +1,156 @@
+// DownloadScheduler.cpp --- the worker threads of the downloads
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "DownloadScheduler.hpp"
+#include <process.h>
+#include <objbase.h>
+#include <cstdio>
+
+MDownloadScheduler::MDownloadScheduler(DOWNLOAD_PROC proc) :
+    m_proc(proc),
+    m_hWake(CreateEventW(NULL, FALSE, FALSE, NULL)),
+    m_hQuit(CreateEventW(NULL, TRUE, FALSE, NULL))
+{
+    InitializeCriticalSection(&m_lock);
+}
+
+MDownloadScheduler::~MDownloadScheduler()
+{
+    // the workers may still use the lock and the events if the wait failed
+    if (!Stop(INFINITE))
+        return;
+
+    CloseHandle(m_hWake);
+    CloseHandle(m_hQuit);
+    DeleteCriticalSection(&m_lock);
+}
+
+void MDownloadScheduler::SetMaxRunning(size_t nMaxRunning)
+{
+    if (nMaxRunning > DOWNLOAD_MAX_WORKERS)
+        nMaxRunning = DOWNLOAD_MAX_WORKERS;
+
+    EnterCriticalSection(&m_lock);
+    m_queue.SetMaxRunning(nMaxRunning);
+    if (!m_threads.empty())
+        DoStartWorkers();
+    LeaveCriticalSection(&m_lock);
+
+    // more jobs may be able to start
+    SetEvent(m_hWake);
+}
+
+// called while locked
+void MDownloadScheduler::DoStartWorkers()
+{
+    while (m_threads.size() < m_queue.GetMaxRunning())
+    {
+        HANDLE hThread = (HANDLE)_beginthreadex(NULL, 0, WorkerProc, this, 0, NULL);
+        if (!hThread)
+            break;
+        m_threads.push_back(hThread);
+    }
+}
+
+DOWNLOAD_ID MDownloadScheduler::Add(void *context, INT nPriority)
+{
+    EnterCriticalSection(&m_lock);
+    DOWNLOAD_ID id = m_queue.Add(context, nPriority);
+    DoStartWorkers();
+    if (m_threads.empty())
+    {
+        m_queue.Remove(id);
+        id = 0;
+    }
+    LeaveCriticalSection(&m_lock);
+
+    if (id)
+        SetEvent(m_hWake);
+    return id;
+}
+
+BOOL MDownloadScheduler::Cancel(DOWNLOAD_ID id)
+{
+    EnterCriticalSection(&m_lock);
+    BOOL bQueued = m_queue.Cancel(id);
+    if (bQueued)
+        m_queue.Remove(id);
+    LeaveCriticalSection(&m_lock);
+    return bQueued;
+}
+
+DOWNLOAD_STATE MDownloadScheduler::GetState(DOWNLOAD_ID id)
+{
+    EnterCriticalSection(&m_lock);
+    DOWNLOAD_STATE state = m_queue.GetState(id);
+    LeaveCriticalSection(&m_lock);
+    return state;
+}
+
+BOOL MDownloadScheduler::Stop(DWORD dwTimeout)
+{
+    if (m_threads.empty())
+        return TRUE;
+
+    SetEvent(m_hQuit);
+    DWORD dwWait = WaitForMultipleObjects(DWORD(m_threads.size()), &m_threads[0],
+                                          TRUE, dwTimeout);
+    if (dwWait == WAIT_TIMEOUT || dwWait == WAIT_FAILED)
+    {
+        // keep the handles to wait again
+        printf("MDownloadScheduler::Stop: %lu\n", dwWait);
+        return FALSE;
+    }
+
+    for (size_t i = 0; i < m_threads.size(); ++i)
+    {
+        CloseHandle(m_threads[i]);
+    }
+    m_threads.clear();
+    return TRUE;
+}
+
+/*static*/ unsigned __stdcall MDownloadScheduler::WorkerProc(void *arg)
+{
+    MDownloadScheduler *pThis = (MDownloadScheduler *)arg;
+    HANDLE ahEvents[2] = { pThis->m_hQuit, pThis->m_hWake };
+
+    HRESULT hr = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+
+    while (WaitForSingleObject(pThis->m_hQuit, 0) != WAIT_OBJECT_0)
+    {
+        void *context = NULL;
+        EnterCriticalSection(&pThis->m_lock);
+        DOWNLOAD_ID id = pThis->m_queue.Start(&context);
+        BOOL bMore = (pThis->m_queue.GetQueuedCount() > 0 &&
+                      pThis->m_queue.GetRunningCount() < pThis->m_queue.GetMaxRunning());
+        LeaveCriticalSection(&pThis->m_lock);
+
+        // the event is auto-reset. pass it to another worker
+        if (bMore)
+            SetEvent(pThis->m_hWake);
+
+        if (!id)
+        {
+            if (WaitForMultipleObjects(2, ahEvents, FALSE, INFINITE) != WAIT_OBJECT_0 + 1)
+                break;
+            continue;
+        }
+
+        (*pThis->m_proc)(id, context);
+
+        EnterCriticalSection(&pThis->m_lock);
+        pThis->m_queue.Finish(id);
+        pThis->m_queue.Remove(id);
+        LeaveCriticalSection(&pThis->m_lock);
+
+        // a slot is free
+        SetEvent(pThis->m_hWake);
+    }
+
+    if (SUCCEEDED(hr))
+        CoUninitialize();
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+// DownloadScheduler.hpp --- the worker threads of the downloads
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef DOWNLOAD_SCHEDULER_HPP_
+#define DOWNLOAD_SCHEDULER_HPP_
+
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+#include <vector>
+#include "DownloadQueue.hpp"
+
+// the maximum number of the worker threads
+#define DOWNLOAD_MAX_WORKERS    8
+
+// runs a job in a worker thread
+typedef void (*DOWNLOAD_PROC)(DOWNLOAD_ID id, void *context);
+
+// A fixed pool of the worker threads runs the jobs of MDownloadQueue.
+// The workers are started on demand, and each one initializes COM once.
+class MDownloadScheduler
+{
+public:
+    MDownloadScheduler(DOWNLOAD_PROC proc);
+    ~MDownloadScheduler();
+
+    // the number of the concurrent downloads
+    void SetMaxRunning(size_t nMaxRunning);
+
+    DOWNLOAD_ID Add(void *context, INT nPriority = 0);
+
+    // returns TRUE if the job was queued. Then the proc is never called
+    // and the caller owns the context.
+    BOOL Cancel(DOWNLOAD_ID id);
+
+    // DOWNLOAD_NONE after the job has finished
+    DOWNLOAD_STATE GetState(DOWNLOAD_ID id);
+
+    // waits for the running jobs. The queued jobs never run; Cancel still
+    // returns TRUE for them. Returns FALSE on timeout; then the workers are
+    // still running and Stop can be called again.
+    BOOL Stop(DWORD dwTimeout);
+
+protected:
+    DOWNLOAD_PROC m_proc;
+    MDownloadQueue m_queue;
+    CRITICAL_SECTION m_lock;
+    HANDLE m_hWake;         // auto-reset: a job is queued or finished
+    HANDLE m_hQuit;         // manual-reset
+    std::vector<HANDLE> m_threads;
+
+    void DoStartWorkers();
+    static unsigned __stdcall WorkerProc(void *arg);
+};
+
+#endif  // ndef DOWNLOAD_SCHEDULER_HPP_
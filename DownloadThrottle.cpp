@@ -0,0 +1,51 @@
+// DownloadThrottle.cpp --- the bandwidth limits of the downloads
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "DownloadThrottle.hpp"
+
+MDownloadThrottle g_download_throttle;
+
+MDownloadThrottle::MDownloadThrottle(TOKEN_CLOCK clock) :
+    m_global(clock),
+    m_pause(clock),
+    m_hResumed(CreateEventW(NULL, TRUE, TRUE, NULL))
+{
+}
+
+MDownloadThrottle::~MDownloadThrottle()
+{
+    CloseHandle(m_hResumed);
+}
+
+// called by the UI thread
+void MDownloadThrottle::Pause(BOOL bPause)
+{
+    m_pause.Pause(bPause != FALSE);
+    if (m_pause.IsPaused())
+        ResetEvent(m_hResumed);
+    else
+        SetEvent(m_hResumed);
+}
+
+void MDownloadThrottle::Throttle(MTokenBucket *pJob, DWORD cb, HANDLE hCancel)
+{
+    DWORD dwPause = m_pause.GetWaitTime();
+    if (dwPause)
+    {
+        HANDLE ahEvents[2] = { m_hResumed, hCancel };
+        WaitForMultipleObjects(2, ahEvents, FALSE, dwPause);
+    }
+
+    // both the debts are paid in the same wait
+    DWORD dwWait = m_global.Consume(cb);
+    if (pJob)
+    {
+        DWORD dwJobWait = pJob->Consume(cb);
+        if (dwWait < dwJobWait)
+            dwWait = dwJobWait;
+    }
+
+    if (dwWait)
+        WaitForSingleObject(hCancel, dwWait);
+}
@@ -0,0 +1,35 @@
+// DownloadThrottle.hpp --- the bandwidth limits of the downloads
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef DOWNLOAD_THROTTLE_HPP_
+#define DOWNLOAD_THROTTLE_HPP_
+
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+#include "TokenBucket.hpp"
+
+// The limit of all the downloads. Each job may have its own bucket too.
+class MDownloadThrottle
+{
+public:
+    MTokenBucket m_global;
+
+    MDownloadThrottle(TOKEN_CLOCK clock = NULL);
+    ~MDownloadThrottle();
+
+    // the downloads wait while paused (see MDownloadPause)
+    void Pause(BOOL bPause);
+
+    // called on the data path after cb bytes have arrived.
+    // The wait ends early when hCancel is signaled.
+    void Throttle(MTokenBucket *pJob, DWORD cb, HANDLE hCancel);
+
+protected:
+    MDownloadPause m_pause;
+    HANDLE m_hResumed;      // manual-reset: not paused
+};
+extern MDownloadThrottle g_download_throttle;
+
+#endif  // ndef DOWNLOAD_THROTTLE_HPP_
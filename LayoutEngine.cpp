@@ -0,0 +1,120 @@
+// LayoutEngine.cpp --- button bar layout engine
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "LayoutEngine.hpp"
+
+static int DoClampSize(int size, int room)
+{
+    if (room <= 0 || size <= 0)
+        return 0;
+    return (size < room) ? size : room;
+}
+
+static void DoSetRect(LAYOUT_RECT& rc, const LAYOUT_RECT& rcBar, bool bVertical,
+                      int pos, int size)
+{
+    if (bVertical)
+    {
+        rc.left = rcBar.left;
+        rc.top = pos;
+        rc.right = rcBar.right;
+        rc.bottom = pos + size;
+    }
+    else
+    {
+        rc.left = pos;
+        rc.top = rcBar.top;
+        rc.right = pos + size;
+        rc.bottom = rcBar.bottom;
+    }
+}
+
+void LayoutBar(const LAYOUT_RECT& rcBar, bool bVertical,
+               const LAYOUT_SPEC *specs, size_t count, LAYOUT_RECT *rects)
+{
+    int start = bVertical ? rcBar.top : rcBar.left;
+    int end = bVertical ? rcBar.bottom : rcBar.right;
+
+    // find the first and the last stars
+    size_t first = count, last = count;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (specs[i].m_star)
+        {
+            if (first == count)
+                first = i;
+            last = i;
+        }
+    }
+
+    // from the start edge
+    size_t i;
+    for (i = 0; i < first; ++i)
+    {
+        int size = DoClampSize(specs[i].m_size, end - start);
+        DoSetRect(rects[i], rcBar, bVertical, start, size);
+        start += size;
+    }
+    if (first == count)
+        return;
+
+    // from the end edge
+    for (i = count; i-- > last + 1; )
+    {
+        int size = DoClampSize(specs[i].m_size, end - start);
+        end -= size;
+        DoSetRect(rects[i], rcBar, bVertical, end, size);
+    }
+
+    // the fixed buttons between the stars take their room first
+    int fixed = 0, stars = 0;
+    for (i = first; i <= last; ++i)
+    {
+        if (specs[i].m_star)
+            ++stars;
+        else if (specs[i].m_size > 0)
+            fixed += specs[i].m_size;
+    }
+
+    // the stars share the rest. The remainder goes to the first ones.
+    int rest = end - start - fixed;
+    if (rest < 0)
+        rest = 0;
+    int share = rest / stars, extra = rest % stars;
+
+    for (i = first; i <= last; ++i)
+    {
+        int size;
+        if (specs[i].m_star)
+        {
+            size = share;
+            if (extra > 0)
+            {
+                ++size;
+                --extra;
+            }
+        }
+        else
+        {
+            size = DoClampSize(specs[i].m_size, end - start);
+        }
+        DoSetRect(rects[i], rcBar, bVertical, start, size);
+        start += size;
+    }
+}
+
+size_t FindMovedButton(const LAYOUT_RECT *rects, const LAYOUT_RECT *applied,
+                       size_t count, size_t i)
+{
+    for (; i < count; ++i)
+    {
+        const LAYOUT_RECT& rc = rects[i], & rcOld = applied[i];
+        if (rc.left != rcOld.left || rc.top != rcOld.top ||
+            rc.right != rcOld.right || rc.bottom != rcOld.bottom)
+        {
+            break;
+        }
+    }
+    return i;
+}
@@ -0,0 +1,42 @@
+// LayoutEngine.hpp --- button bar layout engine
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef LAYOUT_ENGINE_HPP_
+#define LAYOUT_ENGINE_HPP_
+
+#include <cstddef>
+
+// NOTE: This file doesn't depend on Win32 API.
+
+// a rectangle in pixels (same as RECT)
+struct LAYOUT_RECT
+{
+    int left;
+    int top;
+    int right;
+    int bottom;
+};
+
+// a button of a bar
+struct LAYOUT_SPEC
+{
+    int m_size;     // the width (or the height if vertical). ignored if m_star
+    bool m_star;    // "*" shares the rest of the bar
+};
+
+// Lays out the buttons of a bar in rcBar.
+// The buttons before the first "*" are placed from the start edge and the
+// buttons after the last "*" from the end edge. The "*" buttons and the
+// buttons between them share the rest. The buttons are clipped by the bar,
+// so none of them overlaps another one. No allocation.
+void LayoutBar(const LAYOUT_RECT& rcBar, bool bVertical,
+               const LAYOUT_SPEC *specs, size_t count, LAYOUT_RECT *rects);
+
+// Returns the index of the first button from i whose rectangle differs from
+// the applied one, or count if none. The caller moves it, updates applied[i]
+// and goes on from i + 1. No allocation.
+size_t FindMovedButton(const LAYOUT_RECT *rects, const LAYOUT_RECT *applied,
+                       size_t count, size_t i);
+
+#endif  // ndef LAYOUT_ENGINE_HPP_
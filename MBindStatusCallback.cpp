@@ -1,153 +1,242 @@
-// MBindStatusCallback.cpp --- progress info class
-// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
-// This file is public domain software.
-
-#include "MBindStatusCallback.hpp"
-
-/*static*/ MBindStatusCallback *MBindStatusCallback::Create()
-{
-    return new MBindStatusCallback;
-}
-
-MBindStatusCallback::MBindStatusCallback() :
-    m_nRefCount(1),
-    m_bCompleted(FALSE),
-    m_bCancelled(FALSE)
-{
-}
-
-MBindStatusCallback::~MBindStatusCallback()
-{
-}
-
-BOOL MBindStatusCallback::IsCancelled() const
-{
-    return m_bCancelled;
-}
-
-BOOL MBindStatusCallback::IsCompleted() const
-{
-    return m_bCompleted;
-}
-
-// IUnknown interface
-STDMETHODIMP MBindStatusCallback::QueryInterface(REFIID riid, void **ppvObj)
-{
-    if (!ppvObj)
-        return E_POINTER;
-
-    *ppvObj = NULL;
-
-    if (riid == __uuidof(IUnknown) || riid == __uuidof(IBindStatusCallback))
-    {
-        *ppvObj = static_cast<IBindStatusCallback *>(this);
-    }
-    else if (riid == __uuidof(IAuthenticate))
-    {
-        *ppvObj = static_cast<IAuthenticate *>(this);
-    }
-    else
-    {
-        return E_NOINTERFACE;
-    }
-
-    AddRef();
-
-    return S_OK;
-}
-
-STDMETHODIMP_(ULONG) MBindStatusCallback::AddRef()
-{
-    printf("MBindStatusCallback::AddRef\n");
-    return ++m_nRefCount;
-}
-
-STDMETHODIMP_(ULONG) MBindStatusCallback::Release()
-{
-    printf("MBindStatusCallback::Release\n");
-    --m_nRefCount;
-    if (m_nRefCount == 0)
-    {
-        delete this;
-        return 0;
-    }
-    return m_nRefCount;
-}
-
-// IBindStatusCallback interface
-STDMETHODIMP MBindStatusCallback::OnStartBinding(DWORD dwReserved, IBinding *pib)
-{
-    return E_NOTIMPL;
-}
-
-STDMETHODIMP MBindStatusCallback::GetPriority(LONG *pnPriority)
-{
-    return E_NOTIMPL;
-}
-
-STDMETHODIMP MBindStatusCallback::OnLowResource(DWORD reserved)
-{
-    return S_OK;
-}
-
-STDMETHODIMP MBindStatusCallback::OnProgress(
-    ULONG ulProgress,
-    ULONG ulProgressMax,
-    ULONG ulStatusCode,
-    LPCWSTR szStatusText)
-{
-    //printf("%lu / %lu\n", ulProgress, ulProgressMax);
-    m_ulProgress = ulProgress;
-    m_ulProgressMax = ulProgressMax;
-    m_ulStatusCode = ulStatusCode;
-    if (szStatusText)
-        m_strStatus = szStatusText;
-    if (ulStatusCode == BINDSTATUS_ENDDOWNLOADDATA ||
-        ulStatusCode == BINDSTATUS_ENDDOWNLOADCOMPONENTS)
-    {
-        m_bCompleted = TRUE;
-        return S_OK;
-    }
-    if (m_bCancelled)
-    {
-        printf("Cancelled\n");
-        return E_ABORT;
-    }
-    return S_OK;
-}
-
-void MBindStatusCallback::SetCancelled()
-{
-    m_bCancelled = TRUE;
-}
-
-STDMETHODIMP MBindStatusCallback::OnStopBinding(HRESULT hresult, LPCWSTR szError)
-{
-    return E_NOTIMPL;
-}
-
-STDMETHODIMP MBindStatusCallback::GetBindInfo(DWORD *grfBINDF, BINDINFO *pbindinfo)
-{
-    *grfBINDF |= BINDF_GETNEWESTVERSION;
-    return S_OK;
-}
-
-STDMETHODIMP MBindStatusCallback::OnDataAvailable(
-    DWORD grfBSCF,
-    DWORD dwSize,
-    FORMATETC *pformatetc,
-    STGMEDIUM *pstgmed)
-{
-    return E_NOTIMPL;
-}
-
-STDMETHODIMP MBindStatusCallback::OnObjectAvailable(REFIID riid, IUnknown *punk)
-{
-    return E_NOTIMPL;
-}
-
-// IAuthenticate interface
-STDMETHODIMP MBindStatusCallback::Authenticate(HWND *phwnd, LPWSTR *pszUsername, LPWSTR *pszPassword)
-{
-    return E_NOTIMPL;
-}
+// MBindStatusCallback.cpp --- progress info class
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "MBindStatusCallback.hpp"
+#include <climits>
+
+/*static*/ MBindStatusCallback *MBindStatusCallback::Create()
+{
+    return new MBindStatusCallback;
+}
+
+MBindStatusCallback::MBindStatusCallback() :
+    m_ulProgress(0),
+    m_ulProgressMax(0),
+    m_nRefCount(1),
+    m_bCompleted(FALSE),
+    m_bCancelled(FALSE),
+    m_bDiscarded(FALSE),
+    m_hrResult(S_OK),
+    m_hDone(CreateEventW(NULL, TRUE, FALSE, NULL)),
+    m_nThrottled(0),
+    m_cbProgress(0),
+    m_cbProgressMax(0)
+{
+}
+
+MBindStatusCallback::~MBindStatusCallback()
+{
+    if (m_hDone)
+        CloseHandle(m_hDone);
+}
+
+BOOL MBindStatusCallback::IsCancelled() const
+{
+    return m_bCancelled;
+}
+
+BOOL MBindStatusCallback::IsDiscarded() const
+{
+    return m_bDiscarded;
+}
+
+BOOL MBindStatusCallback::IsCompleted() const
+{
+    return m_bCompleted;
+}
+
+HANDLE MBindStatusCallback::GetDoneEvent() const
+{
+    return m_hDone;
+}
+
+BOOL MBindStatusCallback::WaitForDone(DWORD dwTimeout)
+{
+    return WaitForSingleObject(m_hDone, dwTimeout) == WAIT_OBJECT_0;
+}
+
+HRESULT MBindStatusCallback::GetResult() const
+{
+    return m_hrResult;
+}
+
+ULONGLONG MBindStatusCallback::GetProgress() const
+{
+    // a 64-bit read can tear on x86
+    return ULONGLONG(InterlockedCompareExchange64((volatile LONGLONG *)&m_cbProgress, 0, 0));
+}
+
+ULONGLONG MBindStatusCallback::GetProgressMax() const
+{
+    return ULONGLONG(InterlockedCompareExchange64((volatile LONGLONG *)&m_cbProgressMax, 0, 0));
+}
+
+void MBindStatusCallback::Throttle(DWORD cb)
+{
+    // OnProgress doesn't throttle them again
+    InterlockedExchangeAdd64(&m_nThrottled, cb);
+    g_download_throttle.Throttle(&m_bucket, cb, m_hDone);
+}
+
+// IUnknown interface
+STDMETHODIMP MBindStatusCallback::QueryInterface(REFIID riid, void **ppvObj)
+{
+    if (!ppvObj)
+        return E_POINTER;
+
+    *ppvObj = NULL;
+
+    if (riid == __uuidof(IUnknown) || riid == __uuidof(IBindStatusCallback))
+    {
+        *ppvObj = static_cast<IBindStatusCallback *>(this);
+    }
+    else if (riid == __uuidof(IAuthenticate))
+    {
+        *ppvObj = static_cast<IAuthenticate *>(this);
+    }
+    else
+    {
+        return E_NOINTERFACE;
+    }
+
+    AddRef();
+
+    return S_OK;
+}
+
+// the download thread and the dialog share it
+STDMETHODIMP_(ULONG) MBindStatusCallback::AddRef()
+{
+    printf("MBindStatusCallback::AddRef\n");
+    return InterlockedIncrement(&m_nRefCount);
+}
+
+STDMETHODIMP_(ULONG) MBindStatusCallback::Release()
+{
+    printf("MBindStatusCallback::Release\n");
+    LONG nCount = InterlockedDecrement(&m_nRefCount);
+    if (nCount == 0)
+    {
+        delete this;
+        return 0;
+    }
+    return nCount;
+}
+
+// IBindStatusCallback interface
+STDMETHODIMP MBindStatusCallback::OnStartBinding(DWORD dwReserved, IBinding *pib)
+{
+    return E_NOTIMPL;
+}
+
+STDMETHODIMP MBindStatusCallback::GetPriority(LONG *pnPriority)
+{
+    return E_NOTIMPL;
+}
+
+STDMETHODIMP MBindStatusCallback::OnLowResource(DWORD reserved)
+{
+    return S_OK;
+}
+
+STDMETHODIMP MBindStatusCallback::OnProgress(
+    ULONG ulProgress,
+    ULONG ulProgressMax,
+    ULONG ulStatusCode,
+    LPCWSTR szStatusText)
+{
+    return Progress(ulProgress, ulProgressMax, ulStatusCode, szStatusText);
+}
+
+HRESULT MBindStatusCallback::Progress(
+    ULONGLONG cbProgress,
+    ULONGLONG cbProgressMax,
+    ULONG ulStatusCode,
+    LPCWSTR szStatusText)
+{
+    //printf("%I64u / %I64u\n", cbProgress, cbProgressMax);
+    InterlockedExchange64(&m_cbProgress, LONGLONG(cbProgress));
+    InterlockedExchange64(&m_cbProgressMax, LONGLONG(cbProgressMax));
+    m_ulProgress = ULONG(cbProgress > ULONG_MAX ? ULONG_MAX : cbProgress);
+    m_ulProgressMax = ULONG(cbProgressMax > ULONG_MAX ? ULONG_MAX : cbProgressMax);
+    m_ulStatusCode = ulStatusCode;
+    if (szStatusText)
+        m_strStatus = szStatusText;
+    if (ulStatusCode == BINDSTATUS_ENDDOWNLOADDATA ||
+        ulStatusCode == BINDSTATUS_ENDDOWNLOADCOMPONENTS)
+    {
+        m_bCompleted = TRUE;
+        SetEvent(m_hDone);
+        return S_OK;
+    }
+    if (ulStatusCode == BINDSTATUS_BEGINDOWNLOADDATA)
+    {
+        // the bytes of a resumed download aren't throttled
+        InterlockedExchange64(&m_nThrottled, LONGLONG(cbProgress));
+    }
+    else if (ulStatusCode == BINDSTATUS_DOWNLOADINGDATA)
+    {
+        // the new data since the last call
+        ULONGLONG cbThrottled = ULONGLONG(InterlockedCompareExchange64(&m_nThrottled, 0, 0));
+        if (cbProgress > cbThrottled)
+        {
+            InterlockedExchange64(&m_nThrottled, LONGLONG(cbProgress));
+            g_download_throttle.Throttle(&m_bucket, DWORD(cbProgress - cbThrottled), m_hDone);
+        }
+    }
+    if (m_bCancelled)
+    {
+        printf("Cancelled\n");
+        return E_ABORT;
+    }
+    return S_OK;
+}
+
+void MBindStatusCallback::SetCancelled()
+{
+    m_bDiscarded = TRUE;
+    SetStopped();
+}
+
+void MBindStatusCallback::SetStopped()
+{
+    m_bCancelled = TRUE;
+    SetEvent(m_hDone);
+}
+
+STDMETHODIMP MBindStatusCallback::OnStopBinding(HRESULT hresult, LPCWSTR szError)
+{
+    // the last call for the binding, succeeded or not
+    m_hrResult = hresult;
+    if (SUCCEEDED(hresult))
+        m_bCompleted = TRUE;
+    SetEvent(m_hDone);
+    return S_OK;
+}
+
+STDMETHODIMP MBindStatusCallback::GetBindInfo(DWORD *grfBINDF, BINDINFO *pbindinfo)
+{
+    *grfBINDF |= BINDF_GETNEWESTVERSION;
+    return S_OK;
+}
+
+STDMETHODIMP MBindStatusCallback::OnDataAvailable(
+    DWORD grfBSCF,
+    DWORD dwSize,
+    FORMATETC *pformatetc,
+    STGMEDIUM *pstgmed)
+{
+    return E_NOTIMPL;
+}
+
+STDMETHODIMP MBindStatusCallback::OnObjectAvailable(REFIID riid, IUnknown *punk)
+{
+    return E_NOTIMPL;
+}
+
+// IAuthenticate interface
+STDMETHODIMP MBindStatusCallback::Authenticate(HWND *phwnd, LPWSTR *pszUsername, LPWSTR *pszPassword)
+{
+    return E_NOTIMPL;
+}
@@ -1,64 +1,96 @@
-// MBindStatusCallback.hpp --- progress info class
-// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
-// This file is public domain software.
-
-#ifndef MBIND_STATUS_CALLBACK_HPP_
-#define MBIND_STATUS_CALLBACK_HPP_
-
-#ifndef _INC_WINDOWS
-    #include <windows.h>
-#endif
-#include <urlmon.h>
-#include <string>
-
-class MBindStatusCallback :
-    public IBindStatusCallback,
-    public IAuthenticate
-{
-public:
-    static MBindStatusCallback *Create();
-    ULONG m_ulProgress;
-    ULONG m_ulProgressMax;
-    ULONG m_ulStatusCode;
-    std::wstring m_strStatus;
-
-    void SetCancelled();
-    BOOL IsCancelled() const;
-    BOOL IsCompleted() const;
-
-    // IUnknown interface
-    STDMETHODIMP QueryInterface(REFIID riid, void **ppvObj);
-    STDMETHODIMP_(ULONG) AddRef();
-    STDMETHODIMP_(ULONG) Release();
-
-    // IBindStatusCallback interface
-    STDMETHODIMP OnStartBinding(DWORD dwReserved, IBinding *pib);
-    STDMETHODIMP GetPriority(LONG *pnPriority);
-    STDMETHODIMP OnLowResource(DWORD reserved);
-    STDMETHODIMP OnProgress(
-        ULONG ulProgress,
-        ULONG ulProgressMax,
-        ULONG ulStatusCode,
-        LPCWSTR szStatusText);
-    STDMETHODIMP OnStopBinding(HRESULT hresult, LPCWSTR szError);
-    STDMETHODIMP GetBindInfo(DWORD *grfBINDF, BINDINFO *pbindinfo);
-    STDMETHODIMP OnDataAvailable(
-        DWORD grfBSCF,
-        DWORD dwSize,
-        FORMATETC *pformatetc,
-        STGMEDIUM *pstgmed);
-    STDMETHODIMP OnObjectAvailable(REFIID riid, IUnknown *punk);
-
-    // IAuthenticate interface
-    STDMETHODIMP Authenticate(HWND *phwnd, LPWSTR *pszUsername, LPWSTR *pszPassword);
-
-protected:
-    LONG m_nRefCount;
-    BOOL m_bCompleted;
-    BOOL m_bCancelled;
-
-    MBindStatusCallback();
-    ~MBindStatusCallback();
-};
-
-#endif  // ndef MBIND_STATUS_CALLBACK_HPP_
+// MBindStatusCallback.hpp --- progress info class
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef MBIND_STATUS_CALLBACK_HPP_
+#define MBIND_STATUS_CALLBACK_HPP_
+
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+#include <urlmon.h>
+#include <string>
+#include "DownloadThrottle.hpp"
+
+class MBindStatusCallback :
+    public IBindStatusCallback,
+    public IAuthenticate
+{
+public:
+    static MBindStatusCallback *Create();
+    ULONG m_ulProgress;
+    ULONG m_ulProgressMax;
+    ULONG m_ulStatusCode;
+    std::wstring m_strStatus;
+
+    // SetCancelled discards the download (by the user). SetStopped stops
+    // it and keeps the ".part" file to be resumed (on exit).
+    // IsCancelled is TRUE after both.
+    void SetCancelled();
+    void SetStopped();
+    BOOL IsCancelled() const;
+    BOOL IsDiscarded() const;
+    BOOL IsCompleted() const;
+
+    // The done event is signaled when the download is completed, cancelled
+    // or failed. It's manual-reset.
+    HANDLE GetDoneEvent() const;
+    BOOL WaitForDone(DWORD dwTimeout);
+    HRESULT GetResult() const;      // the result of OnStopBinding
+
+    // the 64-bit m_ulProgress and m_ulProgressMax. Thread-safe.
+    ULONGLONG GetProgress() const;
+    ULONGLONG GetProgressMax() const;
+
+    // the limit of this download (see also g_download_throttle)
+    MTokenBucket m_bucket;
+
+    // waits for cb bytes received outside of OnProgress. Thread-safe.
+    void Throttle(DWORD cb);
+
+    // OnProgress with the 64-bit sizes
+    HRESULT Progress(ULONGLONG cbProgress, ULONGLONG cbProgressMax,
+                     ULONG ulStatusCode, LPCWSTR szStatusText);
+
+    // IUnknown interface
+    STDMETHODIMP QueryInterface(REFIID riid, void **ppvObj);
+    STDMETHODIMP_(ULONG) AddRef();
+    STDMETHODIMP_(ULONG) Release();
+
+    // IBindStatusCallback interface
+    STDMETHODIMP OnStartBinding(DWORD dwReserved, IBinding *pib);
+    STDMETHODIMP GetPriority(LONG *pnPriority);
+    STDMETHODIMP OnLowResource(DWORD reserved);
+    STDMETHODIMP OnProgress(
+        ULONG ulProgress,
+        ULONG ulProgressMax,
+        ULONG ulStatusCode,
+        LPCWSTR szStatusText);
+    STDMETHODIMP OnStopBinding(HRESULT hresult, LPCWSTR szError);
+    STDMETHODIMP GetBindInfo(DWORD *grfBINDF, BINDINFO *pbindinfo);
+    STDMETHODIMP OnDataAvailable(
+        DWORD grfBSCF,
+        DWORD dwSize,
+        FORMATETC *pformatetc,
+        STGMEDIUM *pstgmed);
+    STDMETHODIMP OnObjectAvailable(REFIID riid, IUnknown *punk);
+
+    // IAuthenticate interface
+    STDMETHODIMP Authenticate(HWND *phwnd, LPWSTR *pszUsername, LPWSTR *pszPassword);
+
+protected:
+    LONG m_nRefCount;
+    BOOL m_bCompleted;
+    BOOL m_bCancelled;
+    BOOL m_bDiscarded;
+    HRESULT m_hrResult;
+    HANDLE m_hDone;
+    volatile LONGLONG m_nThrottled;     // the bytes already throttled
+    volatile LONGLONG m_cbProgress;     // written by the download thread
+    volatile LONGLONG m_cbProgressMax;
+
+    MBindStatusCallback();
+    ~MBindStatusCallback();
+};
+
+#endif  // ndef MBIND_STATUS_CALLBACK_HPP_
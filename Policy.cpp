@@ -0,0 +1,116 @@
+// Policy.cpp --- the runtime policy of SimpleBrowser
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "Policy.hpp"
+#include "Settings.hpp"
+#include <shellapi.h>
+#include <cstdio>
+
+// HKEY_LOCAL_MACHINE\SOFTWARE\Policies\Katayama Hirofumi MZ\SimpleBrowser
+// has the same value names as the settings.
+static const WCHAR s_szPolicyKey[] =
+    L"SOFTWARE\\Policies\\Katayama Hirofumi MZ\\SimpleBrowser";
+
+#define MAX_FORCED  32
+
+struct FORCED
+{
+    BOOL SETTINGS::*m_member;
+    DWORD m_value;
+};
+static FORCED s_forced[MAX_FORCED];
+static size_t s_forced_count = 0;
+static BOOL s_bCmdLineKiosk = FALSE;
+
+// Two buffers, since the readers are on the UI thread with the writer.
+static POLICY s_policies[2];
+const POLICY *volatile g_pPolicy = &s_policies[0];
+
+static const FORCED *DoFindForced(BOOL SETTINGS::*member)
+{
+    for (size_t i = 0; i < s_forced_count; ++i)
+    {
+        if (s_forced[i].m_member == member)
+            return &s_forced[i];
+    }
+    return NULL;
+}
+
+static BOOL DoResolve(const SETTINGS& settings, BOOL SETTINGS::*member)
+{
+    if (const FORCED *forced = DoFindForced(member))
+        return !!forced->m_value;
+    return settings.*member;
+}
+
+void InitPolicy()
+{
+    s_forced_count = 0;
+
+    HKEY hKey = NULL;
+    RegOpenKeyExW(HKEY_LOCAL_MACHINE, s_szPolicyKey, 0, KEY_READ, &hKey);
+    if (hKey)
+    {
+        for (size_t i = 0; i < g_setting_count && s_forced_count < MAX_FORCED; ++i)
+        {
+            const SETTING_ENTRY& entry = g_setting_entries[i];
+            if (entry.m_type != SETTING_BOOL)
+                continue;
+
+            DWORD value, cb = sizeof(value);
+            if (RegQueryValueExW(hKey, entry.m_name, NULL, NULL, (LPBYTE)&value, &cb))
+                continue;
+
+            printf("policy: %ls = %lu\n", entry.m_name, value);
+            s_forced[s_forced_count].m_member = entry.m_int;
+            s_forced[s_forced_count].m_value = value;
+            ++s_forced_count;
+        }
+        RegCloseKey(hKey);
+    }
+
+    s_bCmdLineKiosk = FALSE;
+    INT argc = 0;
+    if (LPWSTR *wargv = CommandLineToArgvW(GetCommandLineW(), &argc))
+    {
+        for (INT i = 1; i < argc; ++i)
+        {
+            if (lstrcmpW(wargv[i], L"-kiosk") == 0 ||
+                lstrcmpW(wargv[i], L"--kiosk") == 0 ||
+                lstrcmpW(wargv[i], L"/kiosk") == 0)
+            {
+                s_bCmdLineKiosk = TRUE;
+            }
+        }
+        LocalFree(wargv);
+    }
+}
+
+void UpdatePolicy(const SETTINGS& settings)
+{
+    POLICY *pPolicy = &s_policies[(g_pPolicy == &s_policies[0]) ? 1 : 0];
+    ZeroMemory(pPolicy, sizeof(*pPolicy));
+
+    BOOL kiosk = DoResolve(settings, &SETTINGS::m_kiosk_mode);
+    pPolicy->m_kiosk = kiosk;
+    pPolicy->m_kiosk_locked = (DoFindForced(&SETTINGS::m_kiosk_mode) != NULL);
+    pPolicy->m_cmdline_kiosk = s_bCmdLineKiosk;
+    pPolicy->m_local_file_access =
+        DoResolve(settings, &SETTINGS::m_local_file_access) && !kiosk;
+    pPolicy->m_no_popup = DoResolve(settings, &SETTINGS::m_dont_popup) || kiosk;
+    pPolicy->m_no_download = kiosk;
+    pPolicy->m_silent = DoResolve(settings, &SETTINGS::m_ignore_errors) || kiosk;
+    pPolicy->m_secure = DoResolve(settings, &SETTINGS::m_secure) || kiosk;
+    pPolicy->m_no_r_click = DoResolve(settings, &SETTINGS::m_dont_r_click) || kiosk;
+    pPolicy->m_no_context_menu = kiosk;
+
+    InterlockedExchangePointer((PVOID volatile *)&g_pPolicy, pPolicy);
+}
+
+BOOL IsForcedByPolicy(const SETTING_ENTRY& entry)
+{
+    if (entry.m_type != SETTING_BOOL)
+        return FALSE;
+    return DoFindForced(entry.m_int) != NULL;
+}
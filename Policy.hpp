@@ -0,0 +1,53 @@
+// Policy.hpp --- the runtime policy of SimpleBrowser
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef POLICY_HPP_
+#define POLICY_HPP_
+
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+
+struct SETTINGS;
+struct SETTING_ENTRY;
+
+#ifdef _MSC_VER
+    #define POLICY_ALIGN    __declspec(align(64))
+#else
+    #define POLICY_ALIGN    __attribute__((aligned(64)))
+#endif
+
+// The machine policy, the user settings and the command line, resolved.
+// A POLICY is never modified after publishing, so read it freely.
+struct POLICY_ALIGN POLICY
+{
+    unsigned m_kiosk : 1;
+    unsigned m_kiosk_locked : 1;        // the machine policy decides the kiosk mode
+    unsigned m_cmdline_kiosk : 1;       // "-kiosk" option
+    unsigned m_local_file_access : 1;   // allowed and not kiosk
+    unsigned m_no_popup : 1;            // popups open in the main window
+    unsigned m_no_download : 1;
+    unsigned m_silent : 1;              // no script error dialogs
+    unsigned m_secure : 1;              // no insecure contents
+    unsigned m_no_r_click : 1;
+    unsigned m_no_context_menu : 1;
+};
+
+extern const POLICY *volatile g_pPolicy;
+
+inline const POLICY& GetPolicy()
+{
+    return *g_pPolicy;
+}
+
+// reads the machine policy and the command line
+void InitPolicy();
+
+// merges the layers and publishes a new POLICY
+void UpdatePolicy(const SETTINGS& settings);
+
+// is the setting decided by the machine policy?
+BOOL IsForcedByPolicy(const SETTING_ENTRY& entry);
+
+#endif  // ndef POLICY_HPP_
@@ -0,0 +1,123 @@
+// RateEstimator.cpp --- the speed and the remaining time of a download
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "RateEstimator.hpp"
+#include <cmath>
+
+MRateEstimator::MRateEstimator()
+{
+    Reset();
+}
+
+void MRateEstimator::Reset()
+{
+    m_count = 0;
+    m_next = 0;
+    m_smooth = 0;
+    m_has_smooth = false;
+}
+
+const MRateEstimator::SAMPLE& MRateEstimator::DoGetNewest() const
+{
+    return m_samples[(m_next + RATE_WINDOW_SIZE - 1) % RATE_WINDOW_SIZE];
+}
+
+const MRateEstimator::SAMPLE& MRateEstimator::DoGetOldest() const
+{
+    if (m_count < RATE_WINDOW_SIZE)
+        return m_samples[0];
+    return m_samples[m_next];
+}
+
+void MRateEstimator::Update(RATE_BYTES received, RATE_TICK now)
+{
+    if (m_count > 0)
+    {
+        const SAMPLE& newest = DoGetNewest();
+
+        // the tick wraps around
+        RATE_TICK elapsed = now - newest.m_tick;
+        if (elapsed == 0)
+            return;
+
+        // restarted?
+        if (received < newest.m_received)
+        {
+            Reset();
+        }
+        else
+        {
+            double rate = double(received - newest.m_received) * 1000 / elapsed;
+            if (m_has_smooth)
+            {
+                // the weight depends on the interval
+                double alpha = 1 - std::exp(-double(elapsed) / RATE_SMOOTHING_TIME);
+                m_smooth += alpha * (rate - m_smooth);
+            }
+            else
+            {
+                m_smooth = rate;
+                m_has_smooth = true;
+            }
+        }
+    }
+
+    m_samples[m_next].m_received = received;
+    m_samples[m_next].m_tick = now;
+    m_next = (m_next + 1) % RATE_WINDOW_SIZE;
+    if (m_count < RATE_WINDOW_SIZE)
+        ++m_count;
+}
+
+double MRateEstimator::GetWindowRate() const
+{
+    if (m_count < 2)
+        return 0;
+
+    const SAMPLE& newest = DoGetNewest();
+    const SAMPLE& oldest = DoGetOldest();
+    RATE_TICK elapsed = newest.m_tick - oldest.m_tick;
+    if (elapsed == 0)
+        return 0;
+
+    return double(newest.m_received - oldest.m_received) * 1000 / elapsed;
+}
+
+double MRateEstimator::GetSmoothRate() const
+{
+    return m_has_smooth ? m_smooth : 0;
+}
+
+double MRateEstimator::GetRate() const
+{
+    // no progress over the window is a stall, whatever the average says
+    if (m_count >= 2 && DoGetNewest().m_tick != DoGetOldest().m_tick)
+        return GetWindowRate();
+    return GetSmoothRate();
+}
+
+bool MRateEstimator::GetRemainingSeconds(RATE_BYTES total, unsigned long& seconds) const
+{
+    if (m_count == 0)
+        return false;
+
+    RATE_BYTES received = DoGetNewest().m_received;
+    if (received >= total)
+    {
+        seconds = 0;
+        return true;
+    }
+
+    // less than a byte per second is a stall
+    double rate = GetRate();
+    if (!(rate >= 1))
+        return false;
+
+    double remaining = double(total - received) / rate;
+    if (remaining > RATE_MAX_REMAINING)
+        return false;
+
+    seconds = (unsigned long)std::ceil(remaining);
+    return true;
+}
@@ -0,0 +1,63 @@
+// RateEstimator.hpp --- the speed and the remaining time of a download
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef RATE_ESTIMATOR_HPP_
+#define RATE_ESTIMATOR_HPP_
+
+// NOTE: This file doesn't depend on Win32 API.
+
+typedef unsigned long long RATE_BYTES;
+typedef unsigned int RATE_TICK;     // milliseconds. It may wrap around.
+
+// the samples of the window
+#define RATE_WINDOW_SIZE        32
+
+// the time constant of the moving average, in milliseconds
+#define RATE_SMOOTHING_TIME     5000
+
+// the longest remaining time to show, in seconds
+#define RATE_MAX_REMAINING      (100 * 24 * 60 * 60)
+
+// Estimates the speed from the received bytes sampled at any interval.
+// It keeps the rate over the last RATE_WINDOW_SIZE samples in a ring
+// buffer, and an exponentially weighted moving average (EWMA).
+// Each update is O(1).
+class MRateEstimator
+{
+public:
+    MRateEstimator();
+
+    void Reset();
+
+    // the total of the received bytes at the time.
+    // The first sample is the base; the bytes before it aren't counted.
+    void Update(RATE_BYTES received, RATE_TICK now);
+
+    // bytes per second. Zero if unknown.
+    double GetWindowRate() const;
+    double GetSmoothRate() const;
+
+    // the window rate if the window has two samples, otherwise the EWMA
+    double GetRate() const;
+
+    // returns false if the remaining time is unknown
+    bool GetRemainingSeconds(RATE_BYTES total, unsigned long& seconds) const;
+
+protected:
+    struct SAMPLE
+    {
+        RATE_BYTES m_received;
+        RATE_TICK m_tick;
+    };
+    SAMPLE m_samples[RATE_WINDOW_SIZE];
+    unsigned int m_count;       // the number of the samples
+    unsigned int m_next;        // the index of the next sample
+    double m_smooth;
+    bool m_has_smooth;
+
+    const SAMPLE& DoGetNewest() const;
+    const SAMPLE& DoGetOldest() const;
+};
+
+#endif  // ndef RATE_ESTIMATOR_HPP_
@@ -0,0 +1,269 @@
+// SearchSuggest.cpp --- offline search suggestions
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SearchSuggest.hpp"
+#include "Bookmarks.hpp"
+#include <shlwapi.h>
+#include <strsafe.h>
+#include <cstdio>
+
+MSearchSuggest g_search_suggest;
+
+MSearchSuggest::MSearchSuggest() : m_bChanged(FALSE)
+{
+    InitializeCriticalSection(&m_lock);
+}
+
+MSearchSuggest::~MSearchSuggest()
+{
+    DeleteCriticalSection(&m_lock);
+}
+
+void MSearchSuggest::clear()
+{
+    EnterCriticalSection(&m_lock);
+    m_trie.clear();
+    m_bChanged = TRUE;
+    LeaveCriticalSection(&m_lock);
+}
+
+size_t MSearchSuggest::size() const
+{
+    EnterCriticalSection(&m_lock);
+    size_t count = m_trie.size();
+    LeaveCriticalSection(&m_lock);
+    return count;
+}
+
+void MSearchSuggest::Add(const std::wstring& text, DWORD weight)
+{
+    EnterCriticalSection(&m_lock);
+    m_trie.Add(text, weight);
+    m_bChanged = TRUE;
+    LeaveCriticalSection(&m_lock);
+}
+
+size_t MSearchSuggest::Query(const std::wstring& prefix, std::vector<std::wstring>& results,
+                             size_t max_count) const
+{
+    EnterCriticalSection(&m_lock);
+    size_t count = m_trie.Query(prefix, results, max_count);
+    LeaveCriticalSection(&m_lock);
+    return count;
+}
+
+BOOL MSearchSuggest::IsChanged() const
+{
+    EnterCriticalSection(&m_lock);
+    BOOL bChanged = m_bChanged;
+    LeaveCriticalSection(&m_lock);
+    return bChanged;
+}
+
+BOOL MSearchSuggest::Load(LPCWSTR path)
+{
+    FILE *fp = _wfopen(path, L"rb");
+    if (!fp)
+        return FALSE;
+
+    std::string data;
+    char buf[4096];
+    while (size_t count = fread(buf, 1, sizeof(buf), fp))
+    {
+        data.append(buf, count);
+    }
+    fclose(fp);
+
+    EnterCriticalSection(&m_lock);
+    m_trie.Parse(data);
+    m_bChanged = FALSE;
+    LeaveCriticalSection(&m_lock);
+
+    return TRUE;
+}
+
+BOOL MSearchSuggest::Save(LPCWSTR path) const
+{
+    std::string data;
+    EnterCriticalSection(&m_lock);
+    m_trie.Serialize(data);
+    m_bChanged = FALSE;
+    LeaveCriticalSection(&m_lock);
+
+    BOOL bOK = FALSE;
+    FILE *fp = _wfopen(path, L"wb");
+    if (fp)
+    {
+        bOK = data.empty() || (fwrite(data.c_str(), data.size(), 1, fp) == 1);
+        if (fclose(fp) != 0)
+            bOK = FALSE;
+    }
+
+    // saved again next time
+    if (!bOK)
+    {
+        EnterCriticalSection(&m_lock);
+        m_bChanged = TRUE;
+        LeaveCriticalSection(&m_lock);
+    }
+    return bOK;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// MSuggestEnum
+
+// the text of the address bar, set by the UI thread
+static std::wstring s_text;
+static CRITICAL_SECTION s_text_lock;
+static BOOL s_text_lock_ready = FALSE;
+
+/*static*/ MSuggestEnum *MSuggestEnum::Create()
+{
+    // the UI thread creates it before the autocompletion runs
+    if (!s_text_lock_ready)
+    {
+        InitializeCriticalSection(&s_text_lock);
+        s_text_lock_ready = TRUE;
+    }
+    return new MSuggestEnum;
+}
+
+/*static*/ void MSuggestEnum::SetText(const std::wstring& text)
+{
+    if (!s_text_lock_ready)
+        return;
+
+    EnterCriticalSection(&s_text_lock);
+    s_text = text;
+    LeaveCriticalSection(&s_text_lock);
+}
+
+MSuggestEnum::MSuggestEnum() :
+    m_nRefCount(1),
+    m_iItem(0)
+{
+}
+
+MSuggestEnum::~MSuggestEnum()
+{
+}
+
+// IUnknown interface
+STDMETHODIMP MSuggestEnum::QueryInterface(REFIID riid, void **ppvObj)
+{
+    if (!ppvObj)
+        return E_POINTER;
+
+    *ppvObj = NULL;
+
+    if (riid == __uuidof(IUnknown) || riid == __uuidof(IEnumString))
+    {
+        *ppvObj = static_cast<IEnumString *>(this);
+    }
+    else
+    {
+        return E_NOINTERFACE;
+    }
+
+    AddRef();
+
+    return S_OK;
+}
+
+STDMETHODIMP_(ULONG) MSuggestEnum::AddRef()
+{
+    return InterlockedIncrement(&m_nRefCount);
+}
+
+STDMETHODIMP_(ULONG) MSuggestEnum::Release()
+{
+    LONG nCount = InterlockedDecrement(&m_nRefCount);
+    if (nCount == 0)
+    {
+        delete this;
+        return 0;
+    }
+    return nCount;
+}
+
+// IEnumString interface
+STDMETHODIMP MSuggestEnum::Next(ULONG celt, LPOLESTR *rgelt, ULONG *pceltFetched)
+{
+    if (!rgelt)
+        return E_POINTER;
+
+    ULONG i;
+    for (i = 0; i < celt && m_iItem < m_items.size(); ++i, ++m_iItem)
+    {
+        const std::wstring& item = m_items[m_iItem];
+        size_t cb = (item.size() + 1) * sizeof(WCHAR);
+        rgelt[i] = (LPOLESTR)CoTaskMemAlloc(cb);
+        if (!rgelt[i])
+            break;
+        CopyMemory(rgelt[i], item.c_str(), cb);
+    }
+
+    if (pceltFetched)
+        *pceltFetched = i;
+
+    return (i == celt) ? S_OK : S_FALSE;
+}
+
+STDMETHODIMP MSuggestEnum::Skip(ULONG celt)
+{
+    m_iItem += celt;
+    if (m_iItem > m_items.size())
+    {
+        m_iItem = ULONG(m_items.size());
+        return S_FALSE;
+    }
+    return S_OK;
+}
+
+// The autocompletion calls Reset() when the enumerator is reset on each
+// keystroke, so the completions are recomputed from the current text here.
+STDMETHODIMP MSuggestEnum::Reset()
+{
+    m_items.clear();
+    m_iItem = 0;
+
+    WCHAR szText[256];
+    EnterCriticalSection(&s_text_lock);
+    StringCbCopyW(szText, sizeof(szText), s_text.c_str());
+    LeaveCriticalSection(&s_text_lock);
+
+    StrTrimW(szText, L" \t\n\r\f\v");
+    if (szText[0] == 0)
+        return S_OK;
+
+    g_search_suggest.Query(szText, m_items);
+
+    // the UI thread may change the bookmarks
+    std::vector<BOOKMARK_ID> found;
+    g_bookmarks.Lock();
+    g_bookmarks.Search(szText, found, SUGGEST_TOP_COUNT);
+    for (size_t i = 0; i < found.size(); ++i)
+    {
+        m_items.push_back(g_bookmarks[found[i]].m_url);
+    }
+    g_bookmarks.Unlock();
+
+    return S_OK;
+}
+
+STDMETHODIMP MSuggestEnum::Clone(IEnumString **ppenum)
+{
+    if (!ppenum)
+        return E_POINTER;
+
+    MSuggestEnum *pEnum = MSuggestEnum::Create();
+    if (!pEnum)
+        return E_OUTOFMEMORY;
+
+    pEnum->m_items = m_items;
+    pEnum->m_iItem = m_iItem;
+    *ppenum = pEnum;
+    return S_OK;
+}
@@ -0,0 +1,76 @@
+// SearchSuggest.hpp --- offline search suggestions
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef SEARCH_SUGGEST_HPP_
+#define SEARCH_SUGGEST_HPP_
+
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+#include <objidl.h>
+#include <string>
+#include <vector>
+#include "SuggestTrie.hpp"
+
+// MSuggestTrie with the lock and the file.
+// The address bar autocompletion queries it in its own thread, so the
+// methods lock it.
+class MSearchSuggest
+{
+public:
+    MSearchSuggest();
+    ~MSearchSuggest();
+
+    void clear();
+    size_t size() const;
+
+    void Add(const std::wstring& text, DWORD weight = 1);
+    size_t Query(const std::wstring& prefix, std::vector<std::wstring>& results,
+                 size_t max_count = SUGGEST_TOP_COUNT) const;
+
+    // whether Add was called after the last Load or Save
+    BOOL IsChanged() const;
+
+    BOOL Load(LPCWSTR path);
+    BOOL Save(LPCWSTR path) const;
+
+protected:
+    MSuggestTrie m_trie;
+    mutable BOOL m_bChanged;
+    mutable CRITICAL_SECTION m_lock;
+};
+extern MSearchSuggest g_search_suggest;
+
+// IEnumString for the address bar autocompletion.
+// The autocompletion calls it in its own thread, so it doesn't touch the
+// window; the UI thread gives it the text by SetText.
+class MSuggestEnum : public IEnumString
+{
+public:
+    static MSuggestEnum *Create();
+
+    // the text of the address bar. Call it before ResetEnumerator.
+    static void SetText(const std::wstring& text);
+
+    // IUnknown interface
+    STDMETHODIMP QueryInterface(REFIID riid, void **ppvObj);
+    STDMETHODIMP_(ULONG) AddRef();
+    STDMETHODIMP_(ULONG) Release();
+
+    // IEnumString interface
+    STDMETHODIMP Next(ULONG celt, LPOLESTR *rgelt, ULONG *pceltFetched);
+    STDMETHODIMP Skip(ULONG celt);
+    STDMETHODIMP Reset();
+    STDMETHODIMP Clone(IEnumString **ppenum);
+
+protected:
+    LONG m_nRefCount;
+    std::vector<std::wstring> m_items;
+    ULONG m_iItem;
+
+    MSuggestEnum();
+    virtual ~MSuggestEnum();
+};
+
+#endif  // ndef SEARCH_SUGGEST_HPP_
@@ -0,0 +1,168 @@
+// SegmentPlanner.cpp --- splitting a download into byte ranges
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "SegmentPlanner.hpp"
+
+MSegmentPlanner::MSegmentPlanner() : m_total(0), m_received(0), m_min_size(1)
+{
+}
+
+void MSegmentPlanner::Plan(SEGMENT_POS total, size_t count, SEGMENT_POS min_size)
+{
+    m_segments.clear();
+    m_total = total;
+    m_received = 0;
+    m_min_size = min_size ? min_size : 1;
+
+    if (count == 0)
+        count = 1;
+    if (total / m_min_size < count)
+        count = size_t(total / m_min_size);
+    if (count == 0)
+        count = 1;
+
+    SEGMENT_POS size = total / count;
+    SEGMENT_POS pos = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        DOWNLOAD_SEGMENT segment;
+        segment.m_begin = pos;
+        segment.m_end = (i + 1 == count) ? total : pos + size;
+        segment.m_active = false;
+        segment.m_writing = 0;
+        m_segments.push_back(segment);
+        pos = segment.m_end;
+    }
+}
+
+void MSegmentPlanner::SetSegments(SEGMENT_POS total,
+                                  const std::vector<DOWNLOAD_SEGMENT>& segments)
+{
+    m_total = total;
+    m_segments.clear();
+
+    SEGMENT_POS remaining = 0;
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        DOWNLOAD_SEGMENT segment = segments[i];
+        if (segment.m_end > total)
+            segment.m_end = total;
+        if (segment.m_begin >= segment.m_end)
+            continue;
+
+        segment.m_active = false;
+        segment.m_writing = 0;
+        m_segments.push_back(segment);
+        remaining += segment.m_end - segment.m_begin;
+    }
+
+    m_received = (remaining < total) ? total - remaining : 0;
+}
+
+int MSegmentPlanner::Take()
+{
+    for (size_t i = 0; i < m_segments.size(); ++i)
+    {
+        DOWNLOAD_SEGMENT& segment = m_segments[i];
+        if (!segment.m_active && segment.m_begin < segment.m_end)
+        {
+            segment.m_active = true;
+            return int(i);
+        }
+    }
+
+    // steal the second half of the largest one, except the bytes being written
+    int iLargest = -1;
+    SEGMENT_POS largest = 0;
+    for (size_t i = 0; i < m_segments.size(); ++i)
+    {
+        const DOWNLOAD_SEGMENT& segment = m_segments[i];
+        SEGMENT_POS remaining = segment.m_end - segment.m_begin - segment.m_writing;
+        if (remaining > largest)
+        {
+            largest = remaining;
+            iLargest = int(i);
+        }
+    }
+    if (iLargest < 0 || largest < 2 * m_min_size)
+        return -1;
+
+    DOWNLOAD_SEGMENT& victim = m_segments[iLargest];
+    DOWNLOAD_SEGMENT segment;
+    segment.m_begin = victim.m_begin + victim.m_writing + largest / 2;
+    segment.m_end = victim.m_end;
+    segment.m_active = true;
+    segment.m_writing = 0;
+    victim.m_end = segment.m_begin;
+
+    // reuse a finished slot
+    for (size_t i = 0; i < m_segments.size(); ++i)
+    {
+        if (!m_segments[i].m_active && m_segments[i].m_begin >= m_segments[i].m_end)
+        {
+            m_segments[i] = segment;
+            return int(i);
+        }
+    }
+    m_segments.push_back(segment);
+    return int(m_segments.size() - 1);
+}
+
+SEGMENT_POS MSegmentPlanner::Reserve(int i, SEGMENT_POS cb)
+{
+    DOWNLOAD_SEGMENT& segment = m_segments[i];
+    SEGMENT_POS remaining = segment.m_end - segment.m_begin;
+    if (cb > remaining)
+        cb = remaining;
+
+    segment.m_writing = cb;
+    return cb;
+}
+
+void MSegmentPlanner::Advance(int i, SEGMENT_POS cb)
+{
+    DOWNLOAD_SEGMENT& segment = m_segments[i];
+    if (cb > segment.m_writing)
+        cb = segment.m_writing;
+
+    segment.m_begin += cb;
+    segment.m_writing = 0;
+    m_received += cb;
+}
+
+void MSegmentPlanner::Release(int i)
+{
+    m_segments[i].m_active = false;
+    m_segments[i].m_writing = 0;
+}
+
+bool MSegmentPlanner::IsSegmentDone(int i) const
+{
+    return m_segments[i].m_begin >= m_segments[i].m_end;
+}
+
+bool MSegmentPlanner::IsDone() const
+{
+    return m_received >= m_total;
+}
+
+SEGMENT_POS MSegmentPlanner::GetTotal() const
+{
+    return m_total;
+}
+
+SEGMENT_POS MSegmentPlanner::GetReceived() const
+{
+    return m_received;
+}
+
+size_t MSegmentPlanner::GetCount() const
+{
+    return m_segments.size();
+}
+
+const DOWNLOAD_SEGMENT& MSegmentPlanner::GetSegment(int i) const
+{
+    return m_segments[i];
+}
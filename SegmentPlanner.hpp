@@ -0,0 +1,73 @@
+// SegmentPlanner.hpp --- splitting a download into byte ranges
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef SEGMENT_PLANNER_HPP_
+#define SEGMENT_PLANNER_HPP_
+
+#include <cstddef>
+#include <vector>
+
+// NOTE: This file doesn't depend on Win32 API.
+
+typedef unsigned long long SEGMENT_POS;
+
+// the bytes [m_begin, m_end) are not fetched yet
+struct DOWNLOAD_SEGMENT
+{
+    SEGMENT_POS m_begin;
+    SEGMENT_POS m_end;
+    bool m_active;          // a worker is fetching it
+    SEGMENT_POS m_writing;  // the bytes being written at m_begin
+};
+
+// The file is split into the segments, and each worker takes one.
+// When no segment is left, a worker steals the second half of the largest
+// remaining one. A segment advances only after its bytes are written, so
+// the segments are always the bytes not on the disk yet.
+// Not thread-safe; the caller locks it.
+class MSegmentPlanner
+{
+public:
+    MSegmentPlanner();
+
+    // splits [0, total) into count segments of at least min_size bytes
+    void Plan(SEGMENT_POS total, size_t count, SEGMENT_POS min_size);
+
+    // takes a segment to fetch. Returns -1 if there is nothing to do.
+    int Take();
+
+    // the worker of the segment received cb bytes to write at
+    // GetSegment(i).m_begin. Returns the number of the bytes to be written;
+    // it's less than cb if the segment was stolen. They are not stolen
+    // until Advance is called.
+    SEGMENT_POS Reserve(int i, SEGMENT_POS cb);
+
+    // cb bytes of the reserved ones were written (zero on failure).
+    // The segment is done when Reserve returned less than it was given
+    // or IsSegmentDone(i).
+    void Advance(int i, SEGMENT_POS cb);
+
+    // the worker stops fetching the segment (done or failed)
+    void Release(int i);
+
+    bool IsSegmentDone(int i) const;
+    bool IsDone() const;
+
+    SEGMENT_POS GetTotal() const;
+    SEGMENT_POS GetReceived() const;
+
+    size_t GetCount() const;
+    const DOWNLOAD_SEGMENT& GetSegment(int i) const;
+
+    // the remaining segments (e.g. for resuming)
+    void SetSegments(SEGMENT_POS total, const std::vector<DOWNLOAD_SEGMENT>& segments);
+
+protected:
+    std::vector<DOWNLOAD_SEGMENT> m_segments;
+    SEGMENT_POS m_total;
+    SEGMENT_POS m_received;
+    SEGMENT_POS m_min_size;
+};
+
+#endif  // ndef SEGMENT_PLANNER_HPP_
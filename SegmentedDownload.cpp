@@ -0,0 +1,472 @@
+// SegmentedDownload.cpp --- the parallel HTTP range downloads
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "SegmentedDownload.hpp"
+#include <process.h>
+#include <strsafe.h>
+#include <vector>
+#include <cstdio>
+
+// the size of a read
+#define SEGMENT_BUFFER_SIZE     (64 * 1024)
+
+static std::string DoWideToUtf8(const std::wstring& str)
+{
+    std::string ret;
+    if (str.empty())
+        return ret;
+    INT cch = WideCharToMultiByte(CP_UTF8, 0, str.c_str(), INT(str.size()), NULL, 0, NULL, NULL);
+    ret.resize(cch);
+    WideCharToMultiByte(CP_UTF8, 0, str.c_str(), INT(str.size()), &ret[0], cch, NULL, NULL);
+    return ret;
+}
+
+static std::wstring DoUtf8ToWide(const char *str, size_t len)
+{
+    std::wstring ret;
+    if (len == 0)
+        return ret;
+    INT cch = MultiByteToWideChar(CP_UTF8, 0, str, INT(len), NULL, 0);
+    ret.resize(cch);
+    MultiByteToWideChar(CP_UTF8, 0, str, INT(len), &ret[0], cch);
+    return ret;
+}
+
+static std::string DoQueryHeader(HINTERNET hUrl, DWORD dwInfoLevel)
+{
+    WCHAR szText[256];
+    DWORD cb = sizeof(szText);
+    if (!HttpQueryInfoW(hUrl, dwInfoLevel, szText, &cb, NULL))
+        return std::string();
+    return DoWideToUtf8(szText);
+}
+
+MSegmentedDownload::MSegmentedDownload(const std::wstring& url,
+                                       const std::wstring& file,
+                                       MBindStatusCallback *pCallback) :
+    m_url(url),
+    m_file(file),
+    m_part_file(file + DOWNLOAD_PART_SUFFIX),
+    m_sidecar_file(file + DOWNLOAD_SIDECAR_SUFFIX),
+    m_pCallback(pCallback),
+    m_hInternet(NULL),
+    m_hFile(INVALID_HANDLE_VALUE),
+    m_hr(S_OK),
+    m_bChanged(FALSE)
+{
+    InitializeCriticalSection(&m_lock);
+}
+
+MSegmentedDownload::~MSegmentedDownload()
+{
+    if (m_hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(m_hFile);
+    if (m_hInternet)
+        InternetCloseHandle(m_hInternet);
+    DeleteCriticalSection(&m_lock);
+}
+
+HRESULT MSegmentedDownload::Run(size_t nConnections)
+{
+    if (nConnections > SEGMENT_MAX_CONNECTIONS)
+        nConnections = SEGMENT_MAX_CONNECTIONS;
+    if (nConnections < 1)
+        return S_FALSE;
+
+    URL_COMPONENTSW components;
+    ZeroMemory(&components, sizeof(components));
+    components.dwStructSize = sizeof(components);
+    if (!InternetCrackUrlW(m_url.c_str(), 0, 0, &components) ||
+        (components.nScheme != INTERNET_SCHEME_HTTP &&
+         components.nScheme != INTERNET_SCHEME_HTTPS))
+    {
+        return S_FALSE;
+    }
+
+    m_hInternet = InternetOpenW(L"SimpleBrowser", INTERNET_OPEN_TYPE_PRECONFIG,
+                                NULL, NULL, 0);
+    if (!m_hInternet)
+        return S_FALSE;
+
+    if (!DoProbe(m_part) || m_part.m_total < 2 * SEGMENT_MIN_SIZE)
+        return S_FALSE;
+
+    SEGMENT_POS total = m_part.m_total;
+
+    // continue the last one?
+    DOWNLOAD_PART saved;
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    BOOL bResume = DoLoadPart(saved) && saved.Matches(m_part) &&
+                   GetFileAttributesExW(m_part_file.c_str(), GetFileExInfoStandard, &data) &&
+                   ((SEGMENT_POS(data.nFileSizeHigh) << 32) | data.nFileSizeLow) == total;
+    if (bResume)
+        m_planner.SetSegments(total, saved.m_missing);
+    else
+        m_planner.Plan(total, nConnections, SEGMENT_MIN_SIZE);
+
+    printf("MSegmentedDownload: %I64u bytes, %I64u bytes to fetch\n", total,
+           total - m_planner.GetReceived());
+
+    const std::string& validator = m_part.GetValidator();
+    if (validator.size())
+    {
+        m_if_range = L"If-Range: ";
+        m_if_range += DoUtf8ToWide(validator.c_str(), validator.size());
+        m_if_range += L"\r\n";
+    }
+
+    m_hFile = CreateFileW(m_part_file.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                          (bResume ? OPEN_EXISTING : CREATE_ALWAYS),
+                          FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_hFile == INVALID_HANDLE_VALUE)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    if (!bResume)
+    {
+        // preallocate the file
+        LARGE_INTEGER li;
+        li.QuadPart = LONGLONG(total);
+        if (!SetFilePointerEx(m_hFile, li, NULL, FILE_BEGIN) || !SetEndOfFile(m_hFile))
+            return HRESULT_FROM_WIN32(GetLastError());
+    }
+    DoSavePart();
+
+    m_pCallback->Progress(m_planner.GetReceived(), total,
+                          BINDSTATUS_BEGINDOWNLOADDATA, m_url.c_str());
+
+    std::vector<HANDLE> threads;
+    for (size_t i = 0; i < nConnections; ++i)
+    {
+        HANDLE hThread = (HANDLE)_beginthreadex(NULL, 0, WorkerProc, this, 0, NULL);
+        if (!hThread)
+            break;
+        threads.push_back(hThread);
+    }
+    if (threads.empty())
+        return E_FAIL;
+
+    while (WaitForMultipleObjects(DWORD(threads.size()), &threads[0], TRUE,
+                                  SEGMENT_SAVE_INTERVAL) == WAIT_TIMEOUT)
+    {
+        DoSavePart();
+    }
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        CloseHandle(threads[i]);
+    }
+
+    // A discarded download deletes the part. The user doesn't want the
+    // file, and the part is preallocated to the full size. A failed or
+    // stopped one keeps it to be resumed.
+    if (m_bChanged || m_pCallback->IsDiscarded())
+    {
+        // the part is useless
+        CloseHandle(m_hFile);
+        m_hFile = INVALID_HANDLE_VALUE;
+        DeleteFileW(m_sidecar_file.c_str());
+        DeleteFileW(m_part_file.c_str());
+        return FAILED(m_hr) ? m_hr : E_ABORT;
+    }
+
+    if (FAILED(m_hr) || !m_planner.IsDone())
+    {
+        DoSavePart();
+        return FAILED(m_hr) ? m_hr : E_FAIL;
+    }
+
+    CloseHandle(m_hFile);
+    m_hFile = INVALID_HANDLE_VALUE;
+    DeleteFileW(m_sidecar_file.c_str());
+    if (!MoveFileExW(m_part_file.c_str(), m_file.c_str(),
+                     MOVEFILE_REPLACE_EXISTING | MOVEFILE_COPY_ALLOWED))
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    m_pCallback->Progress(total, total, BINDSTATUS_ENDDOWNLOADDATA, m_file.c_str());
+    m_pCallback->OnStopBinding(S_OK, NULL);
+    return S_OK;
+}
+
+// Requests the first byte. A server that supports the ranges answers
+// "206 Partial Content" with "Content-Range: bytes 0-0/<total>".
+// "Accept-Ranges" is optional, but "none" means no.
+BOOL MSegmentedDownload::DoProbe(DOWNLOAD_PART& part)
+{
+    DWORD dwFlags = INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_NO_UI;
+    HINTERNET hUrl = InternetOpenUrlW(m_hInternet, m_url.c_str(), L"Range: bytes=0-0\r\n",
+                                      DWORD(-1), dwFlags, 0);
+    if (!hUrl)
+        return FALSE;
+
+    part = DOWNLOAD_PART();
+    part.m_url = DoWideToUtf8(m_url);
+
+    DWORD dwStatus = 0, cb = sizeof(dwStatus);
+    BOOL bOK = HttpQueryInfoW(hUrl, HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER,
+                              &dwStatus, &cb, NULL) && dwStatus == HTTP_STATUS_PARTIAL_CONTENT;
+
+    if (bOK && lstrcmpiA(DoQueryHeader(hUrl, HTTP_QUERY_ACCEPT_RANGES).c_str(), "none") == 0)
+        bOK = FALSE;
+
+    SEGMENT_POS first, last, total;
+    std::string range = DoQueryHeader(hUrl, HTTP_QUERY_CONTENT_RANGE);
+    if (bOK && ParseContentRange(range, first, last, total) && first == 0)
+        part.m_total = total;
+
+    // the validators for "If-Range". A weak ETag can't be used.
+    part.m_etag = DoQueryHeader(hUrl, HTTP_QUERY_ETAG);
+    if (part.m_etag.compare(0, 2, "W/") == 0)
+        part.m_etag.clear();
+    part.m_last_modified = DoQueryHeader(hUrl, HTTP_QUERY_LAST_MODIFIED);
+
+    InternetCloseHandle(hUrl);
+    return bOK && part.m_total > 0;
+}
+
+BOOL MSegmentedDownload::DoLoadPart(DOWNLOAD_PART& part)
+{
+    HANDLE hFile = CreateFileW(m_sidecar_file.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    std::string text;
+    DWORD cbFile = GetFileSize(hFile, NULL);
+    DWORD cbRead = 0;
+    if (cbFile != INVALID_FILE_SIZE && cbFile < 1024 * 1024)
+    {
+        text.resize(cbFile);
+        if (cbFile && !ReadFile(hFile, &text[0], cbFile, &cbRead, NULL))
+            cbRead = 0;
+        text.resize(cbRead);
+    }
+    CloseHandle(hFile);
+
+    return part.Parse(text);
+}
+
+// The planner advances a segment only after WriteFile has returned, so the
+// snapshot has only the finished writes. They are flushed before the
+// sidecar is replaced, and the sidecar never says that a range is complete
+// when it's not on the disk yet.
+BOOL MSegmentedDownload::DoSavePart()
+{
+    EnterCriticalSection(&m_lock);
+    m_part.m_missing.clear();
+    for (size_t i = 0; i < m_planner.GetCount(); ++i)
+    {
+        m_part.m_missing.push_back(m_planner.GetSegment(int(i)));
+    }
+    std::string text = m_part.Serialize();
+    LeaveCriticalSection(&m_lock);
+
+    if (!FlushFileBuffers(m_hFile))
+        return FALSE;
+
+    std::wstring temp_file = m_sidecar_file + L".tmp";
+    HANDLE hFile = CreateFileW(temp_file.c_str(), GENERIC_WRITE, 0, NULL,
+                               CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    DWORD cbWritten;
+    BOOL bOK = WriteFile(hFile, text.c_str(), DWORD(text.size()), &cbWritten, NULL) &&
+               cbWritten == text.size() && FlushFileBuffers(hFile);
+    CloseHandle(hFile);
+
+    if (bOK)
+        bOK = MoveFileExW(temp_file.c_str(), m_sidecar_file.c_str(),
+                          MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+    if (!bOK)
+        DeleteFileW(temp_file.c_str());
+    return bOK;
+}
+
+HRESULT MSegmentedDownload::DoFetchSegment(int i, SEGMENT_POS& written)
+{
+    written = 0;
+
+    EnterCriticalSection(&m_lock);
+    DOWNLOAD_SEGMENT segment = m_planner.GetSegment(i);
+    LeaveCriticalSection(&m_lock);
+
+    WCHAR szRange[96];
+    StringCbPrintfW(szRange, sizeof(szRange), L"Range: bytes=%I64u-%I64u\r\n",
+                    segment.m_begin, segment.m_end - 1);
+    std::wstring headers = szRange;
+    headers += m_if_range;
+
+    DWORD dwFlags = INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_NO_UI;
+    HINTERNET hUrl = InternetOpenUrlW(m_hInternet, m_url.c_str(), headers.c_str(),
+                                      DWORD(-1), dwFlags, 0);
+    if (!hUrl)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    // "200 OK" is the whole file. With "If-Range", the file was changed.
+    DWORD dwStatus = 0, cb = sizeof(dwStatus);
+    if (!HttpQueryInfoW(hUrl, HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER,
+                        &dwStatus, &cb, NULL) || dwStatus != HTTP_STATUS_PARTIAL_CONTENT)
+    {
+        InternetCloseHandle(hUrl);
+        if (dwStatus == HTTP_STATUS_OK && m_if_range.size())
+        {
+            EnterCriticalSection(&m_lock);
+            m_bChanged = TRUE;
+            LeaveCriticalSection(&m_lock);
+            DoSetError(E_FAIL);
+        }
+        return E_FAIL;
+    }
+
+    // the data is written at m_begin, so it must start there. A server
+    // may ignore or change the range; then the segment is retried.
+    SEGMENT_POS first, last, total;
+    std::string range = DoQueryHeader(hUrl, HTTP_QUERY_CONTENT_RANGE);
+    if (!ParseContentRange(range, first, last, total) || first != segment.m_begin ||
+        (total && total != m_part.m_total))
+    {
+        printf("MSegmentedDownload: unexpected Content-Range: %s\n", range.c_str());
+        InternetCloseHandle(hUrl);
+        return E_FAIL;
+    }
+
+    HRESULT hr = S_OK;
+    std::vector<BYTE> buffer(SEGMENT_BUFFER_SIZE);
+    for (;;)
+    {
+        if (DoIsAborted())
+        {
+            hr = E_ABORT;
+            break;
+        }
+
+        DWORD cbRead = 0;
+        if (!InternetReadFile(hUrl, &buffer[0], DWORD(buffer.size()), &cbRead))
+        {
+            hr = HRESULT_FROM_WIN32(GetLastError());
+            break;
+        }
+        if (cbRead == 0)
+        {
+            // the connection was closed early. The rest will be retried
+            EnterCriticalSection(&m_lock);
+            if (!m_planner.IsSegmentDone(i))
+                hr = E_FAIL;
+            LeaveCriticalSection(&m_lock);
+            break;
+        }
+
+        // the bandwidth limits
+        m_pCallback->Throttle(cbRead);
+
+        // the end of the segment may have been stolen
+        EnterCriticalSection(&m_lock);
+        SEGMENT_POS offset = m_planner.GetSegment(i).m_begin;
+        DWORD cbWrite = DWORD(m_planner.Reserve(i, cbRead));
+        LeaveCriticalSection(&m_lock);
+
+        OVERLAPPED ov;
+        ZeroMemory(&ov, sizeof(ov));
+        ov.Offset = DWORD(offset);
+        ov.OffsetHigh = DWORD(offset >> 32);
+        DWORD cbWritten = 0;
+        if (cbWrite && (!WriteFile(m_hFile, &buffer[0], cbWrite, &cbWritten, &ov) ||
+                        cbWritten != cbWrite))
+        {
+            hr = HRESULT_FROM_WIN32(GetLastError());
+            if (SUCCEEDED(hr))
+                hr = E_FAIL;
+
+            // the range is fetched again
+            EnterCriticalSection(&m_lock);
+            m_planner.Advance(i, 0);
+            LeaveCriticalSection(&m_lock);
+            break;
+        }
+
+        // the bytes are written. The sidecar may say so now.
+        EnterCriticalSection(&m_lock);
+        m_planner.Advance(i, cbWrite);
+        BOOL bDone = (cbWrite < cbRead || m_planner.IsSegmentDone(i));
+        LeaveCriticalSection(&m_lock);
+        written += cbWrite;
+
+        DoReportProgress();
+
+        if (bDone)
+            break;
+    }
+
+    InternetCloseHandle(hUrl);
+    return hr;
+}
+
+void MSegmentedDownload::DoReportProgress()
+{
+    EnterCriticalSection(&m_lock);
+    HRESULT hr = m_pCallback->Progress(m_planner.GetReceived(), m_planner.GetTotal(),
+                                       BINDSTATUS_DOWNLOADINGDATA, NULL);
+    if (FAILED(hr) && SUCCEEDED(m_hr))
+        m_hr = hr;
+    LeaveCriticalSection(&m_lock);
+}
+
+void MSegmentedDownload::DoSetError(HRESULT hr)
+{
+    EnterCriticalSection(&m_lock);
+    if (SUCCEEDED(m_hr))
+        m_hr = hr;
+    LeaveCriticalSection(&m_lock);
+}
+
+BOOL MSegmentedDownload::DoIsAborted()
+{
+    EnterCriticalSection(&m_lock);
+    BOOL bAborted = FAILED(m_hr);
+    LeaveCriticalSection(&m_lock);
+    return bAborted;
+}
+
+/*static*/ unsigned __stdcall MSegmentedDownload::WorkerProc(void *arg)
+{
+    MSegmentedDownload *pThis = (MSegmentedDownload *)arg;
+    INT nRetries = 0;
+
+    for (;;)
+    {
+        // take a segment, or steal a half of the largest one
+        EnterCriticalSection(&pThis->m_lock);
+        int i = FAILED(pThis->m_hr) ? -1 : pThis->m_planner.Take();
+        LeaveCriticalSection(&pThis->m_lock);
+        if (i < 0)
+            break;
+
+        SEGMENT_POS written;
+        HRESULT hr = pThis->DoFetchSegment(i, written);
+
+        EnterCriticalSection(&pThis->m_lock);
+        pThis->m_planner.Release(i);
+        LeaveCriticalSection(&pThis->m_lock);
+
+        if (hr == E_ABORT)
+            break;
+
+        // the retries are for the failures in a row
+        if (written)
+            nRetries = 0;
+
+        if (FAILED(hr))
+        {
+            printf("MSegmentedDownload: segment %d failed (0x%08lX)\n", i, hr);
+            if (++nRetries > SEGMENT_MAX_RETRIES)
+            {
+                pThis->DoSetError(hr);
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
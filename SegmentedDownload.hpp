@@ -0,0 +1,74 @@
+// SegmentedDownload.hpp --- the parallel HTTP range downloads
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef SEGMENTED_DOWNLOAD_HPP_
+#define SEGMENTED_DOWNLOAD_HPP_
+
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+#include <wininet.h>
+#include <urlmon.h>
+#include <string>
+#include "SegmentPlanner.hpp"
+#include "DownloadPart.hpp"
+#include "MBindStatusCallback.hpp"
+
+// the maximum number of the connections of a download
+#define SEGMENT_MAX_CONNECTIONS     8
+
+// a segment isn't split below it. Smaller files use a single stream.
+#define SEGMENT_MIN_SIZE            (1024 * 1024)
+
+// the retries of a failed segment
+#define SEGMENT_MAX_RETRIES         3
+
+// the interval of saving the sidecar, in milliseconds
+#define SEGMENT_SAVE_INTERVAL       2000
+
+// Fetches a file over the connections, each with a "Range" header.
+// The segments are written at their offsets in the preallocated ".part"
+// file, and the missing ranges are saved in the sidecar periodically.
+// If the download stops, the next one continues with "If-Range" as long
+// as the validator on the server is the same.
+// The progress goes to the callback; it aborts if OnProgress fails.
+class MSegmentedDownload
+{
+public:
+    MSegmentedDownload(const std::wstring& url, const std::wstring& file,
+                       MBindStatusCallback *pCallback);
+    ~MSegmentedDownload();
+
+    // returns S_FALSE without writing the file if the server doesn't
+    // support the ranges or the file is small. Then download it as usual.
+    // The ".part" file is kept on failure or stop to be resumed, and
+    // deleted if the callback was discarded.
+    HRESULT Run(size_t nConnections);
+
+protected:
+    std::wstring m_url;
+    std::wstring m_file;
+    std::wstring m_part_file;
+    std::wstring m_sidecar_file;
+    std::wstring m_if_range;    // the "If-Range" header or empty
+    MBindStatusCallback *m_pCallback;
+    HINTERNET m_hInternet;
+    HANDLE m_hFile;
+    MSegmentPlanner m_planner;
+    CRITICAL_SECTION m_lock;
+    HRESULT m_hr;           // the first error
+    BOOL m_bChanged;        // the file on the server was changed
+    DOWNLOAD_PART m_part;
+
+    BOOL DoProbe(DOWNLOAD_PART& part);
+    BOOL DoLoadPart(DOWNLOAD_PART& part);
+    BOOL DoSavePart();
+    HRESULT DoFetchSegment(int i, SEGMENT_POS& written);
+    void DoReportProgress();
+    void DoSetError(HRESULT hr);
+    BOOL DoIsAborted();
+    static unsigned __stdcall WorkerProc(void *arg);
+};
+
+#endif  // ndef SEGMENTED_DOWNLOAD_HPP_
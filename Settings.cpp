@@ -1,503 +1,480 @@
-// Settings.cpp --- SimpleBrowser settings
-// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
-// This file is public domain software.
-
-#include "Settings.hpp"
-#include <windowsx.h>
-#include <shlwapi.h>
-#include <strsafe.h>
-#include "URLListDlg.hpp"
-#include "BlackListDlg.hpp"
-#include "resource.h"
-
-SETTINGS g_settings;
-static std::wstring s_strCurPage;
-
-LPTSTR LoadStringDx(INT nID);
-
-BOOL GetIEVersion(LPWSTR pszVersion, DWORD cchVersionMax)
-{
-    pszVersion[0] = 0;
-    HKEY hKey = NULL;
-    RegOpenKeyExW(HKEY_LOCAL_MACHINE, L"SOFTWARE\\Microsoft\\Internet Explorer", 0,
-        KEY_READ, &hKey);
-    if (hKey)
-    {
-        DWORD cb = cchVersionMax * sizeof(WCHAR);
-        LONG ret = RegQueryValueExW(hKey, L"svcVersion", NULL, NULL, (LPBYTE)pszVersion, &cb);
-        if (ret != ERROR_SUCCESS)
-        {
-            ret = RegQueryValueExW(hKey, L"Version", NULL, NULL, (LPBYTE)pszVersion, &cb);
-        }
-        RegCloseKey(hKey);
-
-        return ret == ERROR_SUCCESS;
-    }
-
-    return FALSE;
-}
-
-
-void SETTINGS::reset()
-{
-    m_x = CW_USEDEFAULT;
-    m_y = CW_USEDEFAULT;
-    m_cx = CW_USEDEFAULT;
-    m_cy = CW_USEDEFAULT;
-    m_bMaximized = FALSE;
-
-    m_homepage = LoadStringDx(IDS_HOMEPAGE);
-    m_url_list.clear();
-    m_black_list.clear();
-    m_secure = TRUE;
-    m_dont_r_click = FALSE;
-    m_local_file_access = TRUE;
-    m_dont_popup = FALSE;
-    m_ignore_errors = TRUE;
-    m_kiosk_mode = FALSE;
-    m_no_virus_scan = FALSE;
-    m_zone_ident = TRUE;
-
-    // FEATURE_BROWSER_EMULATION
-    m_emulation = 0;
-    WCHAR szVersion[32];
-    if (GetIEVersion(szVersion, ARRAYSIZE(szVersion)))
-    {
-        if (szVersion[1] == L'.')
-        {
-            switch (szVersion[0])
-            {
-            case '7':
-                m_emulation = 7000;
-                break;
-            case '8':
-                m_emulation = 8888;
-                break;
-            case '9':
-                m_emulation = 9999;
-                break;
-            }
-        }
-        else if (szVersion[2] == L'.')
-        {
-            if (szVersion[0] == L'1' && szVersion[1] == L'0')
-            {
-                m_emulation = 10001;
-            }
-            if (szVersion[0] == L'1' && szVersion[1] == L'1')
-            {
-                m_emulation = 11001;
-            }
-        }
-    }
-
-    m_refresh_interval = (30 * 1000);  // 30 seconds
-    m_play_sound = TRUE;
-}
-
-BOOL SETTINGS::load()
-{
-    reset();
-
-    static const TCHAR s_szSubKey[] =
-        TEXT("SOFTWARE\\Katayama Hirofumi MZ\\SimpleBrowser");
-
-    BOOL bOK = FALSE;
-    HKEY hApp = NULL;
-    RegOpenKeyEx(HKEY_CURRENT_USER, s_szSubKey, 0, KEY_READ, &hApp);
-    if (hApp)
-    {
-        WCHAR szText[256];
-        DWORD value, cb;
-
-        value = m_x;
-        cb = sizeof(szText);
-        RegQueryValueEx(hApp, L"X", NULL, NULL, (LPBYTE)&value, &cb);
-        m_x = value;
-
-        value = m_y;
-        cb = sizeof(szText);
-        RegQueryValueEx(hApp, L"Y", NULL, NULL, (LPBYTE)&value, &cb);
-        m_y = value;
-
-        value = m_cx;
-        cb = sizeof(szText);
-        RegQueryValueEx(hApp, L"CX", NULL, NULL, (LPBYTE)&value, &cb);
-        m_cx = value;
-
-        value = m_cy;
-        cb = sizeof(szText);
-        RegQueryValueEx(hApp, L"CY", NULL, NULL, (LPBYTE)&value, &cb);
-        m_cy = value;
-
-        value = m_bMaximized;
-        cb = sizeof(szText);
-        RegQueryValueEx(hApp, L"Maximized", NULL, NULL, (LPBYTE)&value, &cb);
-        m_bMaximized = !!value;
-
-        cb = sizeof(szText);
-        RegQueryValueEx(hApp, L"Homepage", NULL, NULL, (LPBYTE)szText, &cb);
-        m_homepage = szText;
-
-        value = m_secure;
-        cb = sizeof(value);
-        RegQueryValueEx(hApp, L"Secure", NULL, NULL, (LPBYTE)&value, &cb);
-        m_secure = !!value;
-
-        value = m_dont_r_click;
-        cb = sizeof(value);
-        RegQueryValueEx(hApp, L"DontRClick", NULL, NULL, (LPBYTE)&value, &cb);
-        m_dont_r_click = !!value;
-
-        value = m_local_file_access;
-        cb = sizeof(value);
-        RegQueryValueEx(hApp, L"LocalFileAccess", NULL, NULL, (LPBYTE)&value, &cb);
-        m_local_file_access = !!value;
-
-        value = m_dont_popup;
-        cb = sizeof(value);
-        RegQueryValueEx(hApp, L"DontPopup", NULL, NULL, (LPBYTE)&value, &cb);
-        m_dont_popup = !!value;
-
-        value = m_ignore_errors;
-        cb = sizeof(value);
-        RegQueryValueEx(hApp, L"IgnoreErrors", NULL, NULL, (LPBYTE)&value, &cb);
-        m_ignore_errors = !!value;
-
-        //value = m_kiosk_mode;
-        //cb = sizeof(value);
-        //RegQueryValueEx(hApp, L"KioskMode", NULL, NULL, (LPBYTE)&value, &cb);
-        //m_kiosk_mode = !!value;
-
-        value = m_no_virus_scan;
-        cb = sizeof(value);
-        RegQueryValueEx(hApp, L"NoVirusScan", NULL, NULL, (LPBYTE)&value, &cb);
-        m_no_virus_scan = !!value;
-
-        value = m_zone_ident;
-        cb = sizeof(value);
-        RegQueryValueEx(hApp, L"ZoneIdent", NULL, NULL, (LPBYTE)&value, &cb);
-        m_zone_ident = !!value;
-
-        value = m_play_sound;
-        cb = sizeof(value);
-        RegQueryValueEx(hApp, L"PlaySound", NULL, NULL, (LPBYTE)&value, &cb);
-        m_play_sound = !!value;
-
-        value = m_emulation;
-        cb = sizeof(value);
-        RegQueryValueEx(hApp, L"Emulation", NULL, NULL, (LPBYTE)&value, &cb);
-        m_emulation = value;
-
-        value = m_refresh_interval;
-        cb = sizeof(value);
-        RegQueryValueEx(hApp, L"RefreshInterval", NULL, NULL, (LPBYTE)&value, &cb);
-        m_refresh_interval = value;
-
-        DWORD count = 0;
-        cb = sizeof(count);
-        RegQueryValueEx(hApp, L"URLCount", NULL, NULL, (LPBYTE)&count, &cb);
-
-        WCHAR szName[64];
-
-        for (DWORD i = 0; i < count; ++i)
-        {
-            StringCbPrintfW(szName, sizeof(szName), L"URL%lu", i);
-
-            cb = sizeof(szText);
-            if (!RegQueryValueEx(hApp, szName, NULL, NULL, (LPBYTE)szText, &cb))
-            {
-                StrTrimW(szText, L" \t\n\r\f\v");
-                m_url_list.push_back(szText);
-            }
-            else
-            {
-                break;
-            }
-        }
-
-        cb = sizeof(count);
-        RegQueryValueEx(hApp, L"ForbiddenCount", NULL, NULL, (LPBYTE)&count, &cb);
-
-        for (DWORD i = 0; i < count; ++i)
-        {
-            StringCbPrintfW(szName, sizeof(szName), L"Forbidden%lu", i);
-
-            cb = sizeof(szText);
-            if (!RegQueryValueEx(hApp, szName, NULL, NULL, (LPBYTE)szText, &cb))
-            {
-                StrTrimW(szText, L" \t\n\r\f\v");
-                m_black_list.push_back(szText);
-            }
-            else
-            {
-                break;
-            }
-        }
-
-        bOK = TRUE;
-    }
-
-    return bOK;
-}
-
-BOOL SETTINGS::save()
-{
-    HKEY hSoftware = NULL;
-    HKEY hCompany = NULL;
-    HKEY hApp = NULL;
-    BOOL bOK = FALSE;
-    RegCreateKeyEx(HKEY_CURRENT_USER, TEXT("SOFTWARE"), 0, NULL, 0,
-                   KEY_ALL_ACCESS, NULL, &hSoftware, NULL);
-    if (hSoftware)
-    {
-        RegCreateKeyEx(hSoftware, TEXT("Katayama Hirofumi MZ"), 0, NULL, 0,
-                       KEY_ALL_ACCESS, NULL, &hCompany, NULL);
-        if (hCompany)
-        {
-            RegCreateKeyEx(hCompany, TEXT("SimpleBrowser"), 0, NULL, 0,
-                           KEY_ALL_ACCESS, NULL, &hApp, NULL);
-            if (hApp)
-            {
-                DWORD value, cb;
-                WCHAR szName[64];
-
-                cb = DWORD((m_homepage.size() + 1) * sizeof(WCHAR));
-                RegSetValueEx(hApp, L"Homepage", 0, REG_SZ, (LPBYTE)m_homepage.c_str(), cb);
-
-                value = DWORD(m_x);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"X", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                value = DWORD(m_y);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"Y", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                value = DWORD(m_cx);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"CX", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                value = DWORD(m_cy);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"CY", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                value = DWORD(m_bMaximized);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"Maximized", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                value = DWORD(m_secure);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"Secure", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                value = DWORD(m_dont_r_click);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"DontRClick", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                value = DWORD(m_local_file_access);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"LocalFileAccess", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                value = DWORD(m_dont_popup);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"DontPopup", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                value = DWORD(m_ignore_errors);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"IgnoreErrors", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                //value = DWORD(m_kiosk_mode);
-                //cb = DWORD(sizeof(value));
-                //RegSetValueEx(hApp, L"KioskMode", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                value = DWORD(m_no_virus_scan);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"NoVirusScan", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                value = DWORD(m_zone_ident);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"ZoneIdent", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                value = DWORD(m_play_sound);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"PlaySound", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                value = DWORD(m_emulation);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"Emulation", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                value = DWORD(m_refresh_interval);
-                cb = DWORD(sizeof(value));
-                RegSetValueEx(hApp, L"RefreshInterval", 0, REG_DWORD, (LPBYTE)&value, cb);
-
-                DWORD count = DWORD(m_url_list.size());
-                cb = DWORD(sizeof(count));
-                RegSetValueEx(hApp, L"URLCount", 0, REG_DWORD, (LPBYTE)&count, cb);
-
-                for (DWORD i = 0; i < count; ++i)
-                {
-                    std::wstring& url = m_url_list[i];
-
-                    StringCbPrintfW(szName, sizeof(szName), L"URL%lu", i);
-
-                    cb = DWORD((url.size() + 1) * sizeof(WCHAR));
-                    RegSetValueEx(hApp, szName, 0, REG_DWORD, (LPBYTE)url.c_str(), cb);
-                }
-
-                count = DWORD(m_black_list.size());
-                cb = DWORD(sizeof(count));
-                RegSetValueEx(hApp, L"ForbiddenCount", 0, REG_DWORD, (LPBYTE)&count, cb);
-
-                for (DWORD i = 0; i < count; ++i)
-                {
-                    std::wstring& url = m_black_list[i];
-
-                    StringCbPrintfW(szName, sizeof(szName), L"Forbidden%lu", i);
-
-                    cb = DWORD((url.size() + 1) * sizeof(WCHAR));
-                    RegSetValueEx(hApp, szName, 0, REG_DWORD, (LPBYTE)url.c_str(), cb);
-                }
-
-                bOK = TRUE;
-                RegCloseKey(hApp);
-            }
-            RegCloseKey(hCompany);
-        }
-        RegCloseKey(hSoftware);
-    }
-
-    return bOK;
-}
-
-static BOOL OnInitDialog(HWND hwnd, HWND hwndFocus, LPARAM lParam)
-{
-    if (g_settings.m_secure)
-        CheckDlgButton(hwnd, chx1, BST_CHECKED);
-    if (g_settings.m_local_file_access)
-        CheckDlgButton(hwnd, chx2, BST_CHECKED);
-    if (g_settings.m_dont_r_click)
-        CheckDlgButton(hwnd, chx3, BST_CHECKED);
-    if (g_settings.m_dont_popup)
-        CheckDlgButton(hwnd, chx4, BST_CHECKED);
-    if (g_settings.m_ignore_errors)
-        CheckDlgButton(hwnd, chx5, BST_CHECKED);
-    if (g_settings.m_kiosk_mode)
-        CheckDlgButton(hwnd, chx6, BST_CHECKED);
-    if (g_settings.m_no_virus_scan)
-        CheckDlgButton(hwnd, chx7, BST_CHECKED);
-    if (g_settings.m_zone_ident)
-        CheckDlgButton(hwnd, chx8, BST_CHECKED);
-    if (g_settings.m_play_sound)
-        CheckDlgButton(hwnd, chx9, BST_CHECKED);
-
-    SetDlgItemText(hwnd, edt1, g_settings.m_homepage.c_str());
-    SetDlgItemInt(hwnd, edt2, g_settings.m_emulation, TRUE);
-
-    if (g_settings.m_kiosk_mode)
-    {
-        EnableWindow(GetDlgItem(hwnd, chx1), FALSE);
-        EnableWindow(GetDlgItem(hwnd, chx2), FALSE);
-        EnableWindow(GetDlgItem(hwnd, chx3), FALSE);
-        EnableWindow(GetDlgItem(hwnd, chx4), FALSE);
-        EnableWindow(GetDlgItem(hwnd, chx5), FALSE);
-    }
-    else
-    {
-        EnableWindow(GetDlgItem(hwnd, chx1), TRUE);
-        EnableWindow(GetDlgItem(hwnd, chx2), TRUE);
-        EnableWindow(GetDlgItem(hwnd, chx3), TRUE);
-        EnableWindow(GetDlgItem(hwnd, chx4), TRUE);
-        EnableWindow(GetDlgItem(hwnd, chx5), TRUE);
-    }
-
-    return TRUE;
-}
-
-static void OnOK(HWND hwnd)
-{
-    g_settings.m_secure = (IsDlgButtonChecked(hwnd, chx1) == BST_CHECKED);
-    g_settings.m_local_file_access = (IsDlgButtonChecked(hwnd, chx2) == BST_CHECKED);
-    g_settings.m_dont_r_click = (IsDlgButtonChecked(hwnd, chx3) == BST_CHECKED);
-    g_settings.m_dont_popup = (IsDlgButtonChecked(hwnd, chx4) == BST_CHECKED);
-    g_settings.m_ignore_errors = (IsDlgButtonChecked(hwnd, chx5) == BST_CHECKED);
-    g_settings.m_kiosk_mode = (IsDlgButtonChecked(hwnd, chx6) == BST_CHECKED);
-    g_settings.m_no_virus_scan = (IsDlgButtonChecked(hwnd, chx7) == BST_CHECKED);
-    g_settings.m_zone_ident = (IsDlgButtonChecked(hwnd, chx8) == BST_CHECKED);
-    g_settings.m_play_sound = (IsDlgButtonChecked(hwnd, chx9) == BST_CHECKED);
-
-    TCHAR szText[256];
-    GetDlgItemText(hwnd, edt1, szText, ARRAYSIZE(szText));
-    g_settings.m_homepage = szText;
-
-    GetDlgItemText(hwnd, edt2, szText, ARRAYSIZE(szText));
-    g_settings.m_emulation = wcstol(szText, NULL, 0);
-
-    EndDialog(hwnd, IDOK);
-}
-
-static void OnCommand(HWND hwnd, int id, HWND hwndCtl, UINT codeNotify)
-{
-    switch (id)
-    {
-    case IDOK:
-        OnOK(hwnd);
-        break;
-    case IDCANCEL:
-        EndDialog(hwnd, id);
-        break;
-    case psh1:
-        SetDlgItemText(hwnd, edt1, s_strCurPage.c_str());
-        break;
-    case psh2:
-        SetDlgItemText(hwnd, edt1, LoadStringDx(IDS_HOMEPAGE));
-        break;
-    case psh3:
-        ShowURLListDlg(GetModuleHandle(NULL), hwnd);
-        break;
-    case psh4:
-        ShowBlackListDlg(GetModuleHandle(NULL), hwnd);
-        break;
-    case psh5:
-        g_settings.m_emulation = 11001;
-        SetDlgItemInt(hwnd, edt2, g_settings.m_emulation, TRUE);
-        break;
-    case psh6:
-        g_settings.reset();
-        EndDialog(hwnd, psh6);
-        break;
-    case chx6:
-        if (IsDlgButtonChecked(hwnd, chx6) == BST_CHECKED)
-        {
-            EnableWindow(GetDlgItem(hwnd, chx1), FALSE);
-            EnableWindow(GetDlgItem(hwnd, chx2), FALSE);
-            EnableWindow(GetDlgItem(hwnd, chx3), FALSE);
-            EnableWindow(GetDlgItem(hwnd, chx4), FALSE);
-            EnableWindow(GetDlgItem(hwnd, chx5), FALSE);
-        }
-        else
-        {
-            EnableWindow(GetDlgItem(hwnd, chx1), TRUE);
-            EnableWindow(GetDlgItem(hwnd, chx2), TRUE);
-            EnableWindow(GetDlgItem(hwnd, chx3), TRUE);
-            EnableWindow(GetDlgItem(hwnd, chx4), TRUE);
-            EnableWindow(GetDlgItem(hwnd, chx5), TRUE);
-        }
-        break;
-    }
-}
-
-static INT_PTR CALLBACK
-SettingsDlgProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
-{
-    switch (uMsg)
-    {
-        HANDLE_MSG(hwnd, WM_INITDIALOG, OnInitDialog);
-        HANDLE_MSG(hwnd, WM_COMMAND, OnCommand);
-    }
-    return 0;
-}
-
-void ShowSettingsDlg(HINSTANCE hInst, HWND hwnd, const std::wstring& strCurPage)
-{
-    s_strCurPage = strCurPage;
-    DialogBox(hInst, MAKEINTRESOURCE(IDD_SETTINGS), hwnd, SettingsDlgProc);
-}
+// Settings.cpp --- SimpleBrowser settings
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "Settings.hpp"
+#include "SettingsBackend.hpp"
+#include "Policy.hpp"
+#include <windowsx.h>
+#include <shlobj.h>
+#include <shlwapi.h>
+#include <strsafe.h>
+#include "URLListDlg.hpp"
+#include "BlackListDlg.hpp"
+#include "resource.h"
+
+SETTINGS g_settings;
+static std::wstring s_strCurPage;
+
+LPTSTR LoadStringDx(INT nID);
+
+BOOL GetIEVersion(LPWSTR pszVersion, DWORD cchVersionMax)
+{
+    pszVersion[0] = 0;
+    HKEY hKey = NULL;
+    RegOpenKeyExW(HKEY_LOCAL_MACHINE, L"SOFTWARE\\Microsoft\\Internet Explorer", 0,
+        KEY_READ, &hKey);
+    if (hKey)
+    {
+        DWORD cb = cchVersionMax * sizeof(WCHAR);
+        LONG ret = RegQueryValueExW(hKey, L"svcVersion", NULL, NULL, (LPBYTE)pszVersion, &cb);
+        if (ret != ERROR_SUCCESS)
+        {
+            ret = RegQueryValueExW(hKey, L"Version", NULL, NULL, (LPBYTE)pszVersion, &cb);
+        }
+        RegCloseKey(hKey);
+
+        return ret == ERROR_SUCCESS;
+    }
+
+    return FALSE;
+}
+
+
+#define SETTING_INT_ENTRY(name, member, value, ctrl, flags) \
+    { name, SETTING_INT, &SETTINGS::member, NULL, NULL, NULL, DWORD(value), ctrl, flags }
+#define SETTING_BOOL_ENTRY(name, member, value, ctrl, flags) \
+    { name, SETTING_BOOL, &SETTINGS::member, NULL, NULL, NULL, DWORD(value), ctrl, flags }
+#define SETTING_DWORD_ENTRY(name, member, value, ctrl, flags) \
+    { name, SETTING_DWORD, NULL, &SETTINGS::member, NULL, NULL, DWORD(value), ctrl, flags }
+#define SETTING_STRING_ENTRY(name, member, value, ctrl, flags) \
+    { name, SETTING_STRING, NULL, NULL, &SETTINGS::member, NULL, DWORD(value), ctrl, flags }
+#define SETTING_LIST_ENTRY(name, member, ctrl, flags) \
+    { name, SETTING_LIST, NULL, NULL, NULL, &SETTINGS::member, 0, ctrl, flags }
+
+// the settings schema
+const SETTING_ENTRY g_setting_entries[] =
+{
+    // the window of each process has its own place
+    SETTING_INT_ENTRY(L"X", m_x, DWORD(CW_USEDEFAULT), 0, SETTING_LOCAL),
+    SETTING_INT_ENTRY(L"Y", m_y, DWORD(CW_USEDEFAULT), 0, SETTING_LOCAL),
+    SETTING_INT_ENTRY(L"CX", m_cx, DWORD(CW_USEDEFAULT), 0, SETTING_LOCAL),
+    SETTING_INT_ENTRY(L"CY", m_cy, DWORD(CW_USEDEFAULT), 0, SETTING_LOCAL),
+    SETTING_BOOL_ENTRY(L"Maximized", m_bMaximized, FALSE, 0, SETTING_LOCAL),
+    SETTING_STRING_ENTRY(L"Homepage", m_homepage, IDS_HOMEPAGE, edt1, 0),
+    SETTING_BOOL_ENTRY(L"Secure", m_secure, TRUE, chx1, 0),
+    SETTING_BOOL_ENTRY(L"LocalFileAccess", m_local_file_access, TRUE, chx2, 0),
+    SETTING_BOOL_ENTRY(L"DontRClick", m_dont_r_click, FALSE, chx3, 0),
+    SETTING_BOOL_ENTRY(L"DontPopup", m_dont_popup, FALSE, chx4, 0),
+    SETTING_BOOL_ENTRY(L"IgnoreErrors", m_ignore_errors, TRUE, chx5, 0),
+    // the kiosk mode is for the session only (see also "-kiosk" option)
+    SETTING_BOOL_ENTRY(L"KioskMode", m_kiosk_mode, FALSE, chx6, SETTING_TRANSIENT),
+    SETTING_BOOL_ENTRY(L"NoVirusScan", m_no_virus_scan, FALSE, chx7, 0),
+    SETTING_BOOL_ENTRY(L"ZoneIdent", m_zone_ident, TRUE, chx8, 0),
+    SETTING_BOOL_ENTRY(L"PlaySound", m_play_sound, TRUE, chx9, 0),
+    // the default depends on the IE version (see SETTINGS::reset)
+    SETTING_DWORD_ENTRY(L"Emulation", m_emulation, 0, edt2, 0),
+    SETTING_DWORD_ENTRY(L"RefreshInterval", m_refresh_interval, 30 * 1000, 0, 0),
+    // the number of the concurrent downloads
+    SETTING_DWORD_ENTRY(L"MaxDownloads", m_max_downloads, 3, 0, 0),
+    // the connections of a range download (0 for URLDownloadToFile)
+    SETTING_DWORD_ENTRY(L"DownloadConnections", m_download_connections, 4, 0, 0),
+    // the bandwidth of all the downloads and of each one, in KB/s (0 for unlimited)
+    SETTING_DWORD_ENTRY(L"DownloadRate", m_download_rate, 0, 0, 0),
+    SETTING_DWORD_ENTRY(L"DownloadJobRate", m_download_job_rate, 0, 0, 0),
+    // the downloads wait while a page is loading
+    SETTING_BOOL_ENTRY(L"PauseDownloads", m_pause_downloads, FALSE, 0, 0),
+    // "URLOrder" and "URL0", "URL1", ...
+    SETTING_LIST_ENTRY(L"URL", m_url_list, 0, 0),
+    SETTING_LIST_ENTRY(L"Forbidden", m_black_list, 0, 0),
+    SETTING_STRING_ENTRY(L"ProbeStamp", m_probe_stamp, 0, 0, SETTING_CACHE),
+    SETTING_DWORD_ENTRY(L"ProbeEmulation", m_probe_emulation, 0, 0, SETTING_CACHE),
+};
+const size_t g_setting_count = ARRAYSIZE(g_setting_entries);
+
+DWORD SETTINGS::GetDword(const SETTING_ENTRY& entry) const
+{
+    if (entry.m_type == SETTING_DWORD)
+        return this->*entry.m_dword;
+    return DWORD(this->*entry.m_int);
+}
+
+void SETTINGS::SetDword(const SETTING_ENTRY& entry, DWORD value)
+{
+    switch (entry.m_type)
+    {
+    case SETTING_INT:
+        this->*entry.m_int = INT(value);
+        break;
+    case SETTING_BOOL:
+        this->*entry.m_int = !!value;
+        break;
+    default:
+        this->*entry.m_dword = value;
+        break;
+    }
+}
+
+std::wstring& SETTINGS::String(const SETTING_ENTRY& entry)
+{
+    return this->*entry.m_string;
+}
+
+const std::wstring& SETTINGS::String(const SETTING_ENTRY& entry) const
+{
+    return this->*entry.m_string;
+}
+
+SETTINGS::list_type& SETTINGS::List(const SETTING_ENTRY& entry)
+{
+    return this->*entry.m_list;
+}
+
+const SETTINGS::list_type& SETTINGS::List(const SETTING_ENTRY& entry) const
+{
+    return this->*entry.m_list;
+}
+
+BOOL SETTINGS::IsSame(const SETTINGS& other, const SETTING_ENTRY& entry) const
+{
+    switch (entry.m_type)
+    {
+    case SETTING_INT:
+    case SETTING_BOOL:
+    case SETTING_DWORD:
+        return GetDword(entry) == other.GetDword(entry);
+    case SETTING_STRING:
+        return String(entry) == other.String(entry);
+    case SETTING_LIST:
+        return List(entry) == other.List(entry);
+    }
+    return FALSE;
+}
+
+void SETTINGS::Assign(const SETTINGS& other, const SETTING_ENTRY& entry)
+{
+    switch (entry.m_type)
+    {
+    case SETTING_INT:
+    case SETTING_BOOL:
+    case SETTING_DWORD:
+        SetDword(entry, other.GetDword(entry));
+        break;
+    case SETTING_STRING:
+        String(entry) = other.String(entry);
+        break;
+    case SETTING_LIST:
+        List(entry) = other.List(entry);
+        break;
+    }
+}
+
+// FEATURE_BROWSER_EMULATION
+static DWORD DoGetDefaultEmulation(void)
+{
+    DWORD emulation = 0;
+    WCHAR szVersion[32];
+    if (GetIEVersion(szVersion, ARRAYSIZE(szVersion)))
+    {
+        if (szVersion[1] == L'.')
+        {
+            switch (szVersion[0])
+            {
+            case '7':
+                emulation = 7000;
+                break;
+            case '8':
+                emulation = 8888;
+                break;
+            case '9':
+                emulation = 9999;
+                break;
+            }
+        }
+        else if (szVersion[2] == L'.')
+        {
+            if (szVersion[0] == L'1' && szVersion[1] == L'0')
+            {
+                emulation = 10001;
+            }
+            if (szVersion[0] == L'1' && szVersion[1] == L'1')
+            {
+                emulation = 11001;
+            }
+        }
+    }
+    return emulation;
+}
+
+// "<mshtml.dll timestamp>|<program path>|<emulation>"
+std::wstring GetProbeStamp(DWORD emulation)
+{
+    WCHAR szPath[MAX_PATH];
+    GetSystemDirectoryW(szPath, ARRAYSIZE(szPath));
+    PathAppendW(szPath, L"mshtml.dll");
+
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    ZeroMemory(&data, sizeof(data));
+    GetFileAttributesExW(szPath, GetFileExInfoStandard, &data);
+
+    GetModuleFileNameW(NULL, szPath, ARRAYSIZE(szPath));
+
+    WCHAR szStamp[MAX_PATH + 64];
+    StringCbPrintfW(szStamp, sizeof(szStamp), L"%08lX%08lX|%s|%lu",
+                    data.ftLastWriteTime.dwHighDateTime,
+                    data.ftLastWriteTime.dwLowDateTime, szPath, emulation);
+    return szStamp;
+}
+
+// GetIEVersion is cached while mshtml.dll is not updated
+DWORD SETTINGS::GetDefaultEmulation()
+{
+    std::wstring stamp = GetProbeStamp(0);
+    size_t ich = stamp.find(L'|') + 1;
+    if (m_probe_stamp.compare(0, ich, stamp, 0, ich) == 0)
+        return m_probe_emulation;
+
+    m_probe_emulation = DoGetDefaultEmulation();
+    m_probe_stamp = stamp.substr(0, ich);
+    return m_probe_emulation;
+}
+
+static void DoResetValues(SETTINGS& settings)
+{
+    WCHAR szText[1024];
+    for (size_t i = 0; i < g_setting_count; ++i)
+    {
+        const SETTING_ENTRY& entry = g_setting_entries[i];
+        if (entry.m_flags & SETTING_CACHE)
+            continue;
+
+        switch (entry.m_type)
+        {
+        case SETTING_INT:
+        case SETTING_BOOL:
+        case SETTING_DWORD:
+            settings.SetDword(entry, entry.m_default);
+            break;
+        case SETTING_STRING:
+            // a startup task loads the settings. LoadStringDx isn't thread-safe
+            szText[0] = 0;
+            if (entry.m_default)
+                LoadStringW(NULL, entry.m_default, szText, ARRAYSIZE(szText));
+            settings.String(entry) = szText;
+            break;
+        case SETTING_LIST:
+            settings.List(entry).clear();
+            break;
+        }
+    }
+}
+
+void SETTINGS::reset()
+{
+    DoResetValues(*this);
+    m_emulation = GetDefaultEmulation();
+}
+
+#define EMULATION_UNKNOWN   0xFFFFFFFF
+
+BOOL SETTINGS::load()
+{
+    // probe the default emulation only if not stored
+    DoResetValues(*this);
+    m_emulation = EMULATION_UNKNOWN;
+
+    BOOL bOK = GetSettingsBackend()->Load(*this);
+
+    if (m_emulation == EMULATION_UNKNOWN)
+        m_emulation = GetDefaultEmulation();
+
+    return bOK;
+}
+
+BOOL SETTINGS::save()
+{
+    return GetSettingsBackend()->Save(*this);
+}
+
+// the settings decided by the machine policy cannot be changed
+static void DoDisableForced(HWND hwnd)
+{
+    for (size_t i = 0; i < g_setting_count; ++i)
+    {
+        const SETTING_ENTRY& entry = g_setting_entries[i];
+        if (entry.m_ctrl && IsForcedByPolicy(entry))
+            EnableWindow(GetDlgItem(hwnd, entry.m_ctrl), FALSE);
+    }
+}
+
+static BOOL OnInitDialog(HWND hwnd, HWND hwndFocus, LPARAM lParam)
+{
+    for (size_t i = 0; i < g_setting_count; ++i)
+    {
+        const SETTING_ENTRY& entry = g_setting_entries[i];
+        if (!entry.m_ctrl)
+            continue;
+
+        switch (entry.m_type)
+        {
+        case SETTING_BOOL:
+            if (g_settings.GetDword(entry))
+                CheckDlgButton(hwnd, entry.m_ctrl, BST_CHECKED);
+            break;
+        case SETTING_INT:
+        case SETTING_DWORD:
+            SetDlgItemInt(hwnd, entry.m_ctrl, g_settings.GetDword(entry), entry.m_type == SETTING_INT);
+            break;
+        case SETTING_STRING:
+            SetDlgItemText(hwnd, entry.m_ctrl, g_settings.String(entry).c_str());
+            break;
+        case SETTING_LIST:
+            break;
+        }
+    }
+
+    if (g_settings.m_kiosk_mode)
+    {
+        EnableWindow(GetDlgItem(hwnd, chx1), FALSE);
+        EnableWindow(GetDlgItem(hwnd, chx2), FALSE);
+        EnableWindow(GetDlgItem(hwnd, chx3), FALSE);
+        EnableWindow(GetDlgItem(hwnd, chx4), FALSE);
+        EnableWindow(GetDlgItem(hwnd, chx5), FALSE);
+    }
+    else
+    {
+        EnableWindow(GetDlgItem(hwnd, chx1), TRUE);
+        EnableWindow(GetDlgItem(hwnd, chx2), TRUE);
+        EnableWindow(GetDlgItem(hwnd, chx3), TRUE);
+        EnableWindow(GetDlgItem(hwnd, chx4), TRUE);
+        EnableWindow(GetDlgItem(hwnd, chx5), TRUE);
+    }
+    DoDisableForced(hwnd);
+
+    return TRUE;
+}
+
+static void OnOK(HWND hwnd)
+{
+    TCHAR szText[256];
+    for (size_t i = 0; i < g_setting_count; ++i)
+    {
+        const SETTING_ENTRY& entry = g_setting_entries[i];
+        if (!entry.m_ctrl)
+            continue;
+
+        switch (entry.m_type)
+        {
+        case SETTING_BOOL:
+            g_settings.SetDword(entry, IsDlgButtonChecked(hwnd, entry.m_ctrl) == BST_CHECKED);
+            break;
+        case SETTING_INT:
+        case SETTING_DWORD:
+            GetDlgItemText(hwnd, entry.m_ctrl, szText, ARRAYSIZE(szText));
+            g_settings.SetDword(entry, wcstol(szText, NULL, 0));
+            break;
+        case SETTING_STRING:
+            GetDlgItemText(hwnd, entry.m_ctrl, szText, ARRAYSIZE(szText));
+            g_settings.String(entry) = szText;
+            break;
+        case SETTING_LIST:
+            break;
+        }
+    }
+
+    EndDialog(hwnd, IDOK);
+}
+
+static void OnCommand(HWND hwnd, int id, HWND hwndCtl, UINT codeNotify)
+{
+    switch (id)
+    {
+    case IDOK:
+        OnOK(hwnd);
+        break;
+    case IDCANCEL:
+        EndDialog(hwnd, id);
+        break;
+    case psh1:
+        SetDlgItemText(hwnd, edt1, s_strCurPage.c_str());
+        break;
+    case psh2:
+        SetDlgItemText(hwnd, edt1, LoadStringDx(IDS_HOMEPAGE));
+        break;
+    case psh3:
+        ShowURLListDlg(GetModuleHandle(NULL), hwnd);
+        break;
+    case psh4:
+        ShowBlackListDlg(GetModuleHandle(NULL), hwnd);
+        break;
+    case psh5:
+        g_settings.m_emulation = 11001;
+        SetDlgItemInt(hwnd, edt2, g_settings.m_emulation, TRUE);
+        break;
+    case psh6:
+        g_settings.reset();
+        EndDialog(hwnd, psh6);
+        break;
+    case chx6:
+        if (IsDlgButtonChecked(hwnd, chx6) == BST_CHECKED)
+        {
+            EnableWindow(GetDlgItem(hwnd, chx1), FALSE);
+            EnableWindow(GetDlgItem(hwnd, chx2), FALSE);
+            EnableWindow(GetDlgItem(hwnd, chx3), FALSE);
+            EnableWindow(GetDlgItem(hwnd, chx4), FALSE);
+            EnableWindow(GetDlgItem(hwnd, chx5), FALSE);
+        }
+        else
+        {
+            EnableWindow(GetDlgItem(hwnd, chx1), TRUE);
+            EnableWindow(GetDlgItem(hwnd, chx2), TRUE);
+            EnableWindow(GetDlgItem(hwnd, chx3), TRUE);
+            EnableWindow(GetDlgItem(hwnd, chx4), TRUE);
+            EnableWindow(GetDlgItem(hwnd, chx5), TRUE);
+        }
+        DoDisableForced(hwnd);
+        break;
+    }
+}
+
+static INT_PTR CALLBACK
+SettingsDlgProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+    switch (uMsg)
+    {
+        HANDLE_MSG(hwnd, WM_INITDIALOG, OnInitDialog);
+        HANDLE_MSG(hwnd, WM_COMMAND, OnCommand);
+    }
+    return 0;
+}
+
+// get the path of a data file in "%APPDATA%\Katayama Hirofumi MZ\SimpleBrowser"
+std::wstring GetSettingsFilePath(LPCWSTR filename)
+{
+    WCHAR szPath[MAX_PATH];
+    if (IsPortableMode())
+    {
+        // next to the program
+        GetModuleFileNameW(NULL, szPath, ARRAYSIZE(szPath));
+        PathRemoveFileSpecW(szPath);
+        PathAppendW(szPath, filename);
+        return szPath;
+    }
+
+    if (FAILED(SHGetFolderPathW(NULL, CSIDL_APPDATA, NULL, SHGFP_TYPE_CURRENT, szPath)))
+        return std::wstring();
+
+    PathAppendW(szPath, L"Katayama Hirofumi MZ");
+    CreateDirectoryW(szPath, NULL);
+    PathAppendW(szPath, L"SimpleBrowser");
+    CreateDirectoryW(szPath, NULL);
+    PathAppendW(szPath, filename);
+
+    return szPath;
+}
+
+void ShowSettingsDlg(HINSTANCE hInst, HWND hwnd, const std::wstring& strCurPage)
+{
+    s_strCurPage = strCurPage;
+    DialogBox(hInst, MAKEINTRESOURCE(IDD_SETTINGS), hwnd, SettingsDlgProc);
+}
@@ -1,42 +1,100 @@
-// Settings.hpp --- SimpleBrowser settings
-// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
-// This file is public domain software.
-
-#ifndef SETTINGS_HPP_
-#define SETTINGS_HPP_
-
-#ifndef _INC_WINDOWS
-    #include <windows.h>
-#endif
-#include <string>
-#include <vector>
-
-struct SETTINGS
-{
-    INT m_x, m_y, m_cx, m_cy;
-    BOOL m_bMaximized;
-    std::wstring m_homepage;
-    typedef std::vector<std::wstring> list_type;
-    list_type m_url_list;
-    list_type m_black_list;
-    BOOL m_secure;
-    BOOL m_dont_r_click;
-    BOOL m_local_file_access;
-    BOOL m_dont_popup;
-    BOOL m_ignore_errors;
-    BOOL m_kiosk_mode;
-    BOOL m_no_virus_scan;
-    BOOL m_zone_ident;
-    BOOL m_play_sound;
-    DWORD m_emulation;
-    DWORD m_refresh_interval;
-
-    BOOL load();
-    BOOL save();
-    void reset();
-};
-extern SETTINGS g_settings;
-
-void ShowSettingsDlg(HINSTANCE hInst, HWND hwnd, const std::wstring& strCurPage);
-
-#endif  // ndef SETTINGS_HPP_
+// Settings.hpp --- SimpleBrowser settings
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef SETTINGS_HPP_
+#define SETTINGS_HPP_
+
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+#include <string>
+#include <vector>
+
+// the types of the settings entries
+enum SETTING_TYPE
+{
+    SETTING_INT,
+    SETTING_BOOL,
+    SETTING_DWORD,
+    SETTING_STRING,
+    SETTING_LIST
+};
+
+// SETTING_ENTRY.m_flags
+#define SETTING_TRANSIENT   0x1     // not stored
+#define SETTING_CACHE       0x2     // stored but not reset
+#define SETTING_LOCAL       0x4     // not taken from the other processes
+
+struct SETTING_ENTRY;
+
+struct SETTINGS
+{
+    INT m_x, m_y, m_cx, m_cy;
+    BOOL m_bMaximized;
+    std::wstring m_homepage;
+    typedef std::vector<std::wstring> list_type;
+    list_type m_url_list;
+    list_type m_black_list;
+    BOOL m_secure;
+    BOOL m_dont_r_click;
+    BOOL m_local_file_access;
+    BOOL m_dont_popup;
+    BOOL m_ignore_errors;
+    BOOL m_kiosk_mode;
+    BOOL m_no_virus_scan;
+    BOOL m_zone_ident;
+    BOOL m_play_sound;
+    DWORD m_emulation;
+    DWORD m_refresh_interval;
+    DWORD m_max_downloads;
+    DWORD m_download_connections;
+    DWORD m_download_rate;
+    DWORD m_download_job_rate;
+    BOOL m_pause_downloads;
+
+    // the cache of the environment probes
+    std::wstring m_probe_stamp;     // see GetProbeStamp
+    DWORD m_probe_emulation;        // the default of m_emulation
+
+    BOOL load();
+    BOOL save();
+    void reset();
+    DWORD GetDefaultEmulation();
+
+    // access by the schema entry
+    DWORD GetDword(const SETTING_ENTRY& entry) const;
+    void SetDword(const SETTING_ENTRY& entry, DWORD value);
+    std::wstring& String(const SETTING_ENTRY& entry);
+    const std::wstring& String(const SETTING_ENTRY& entry) const;
+    list_type& List(const SETTING_ENTRY& entry);
+    const list_type& List(const SETTING_ENTRY& entry) const;
+    BOOL IsSame(const SETTINGS& other, const SETTING_ENTRY& entry) const;
+    void Assign(const SETTINGS& other, const SETTING_ENTRY& entry);
+};
+extern SETTINGS g_settings;
+
+// The member pointer of the type is set and the others are NULL, so each
+// field is accessed as its own type.
+struct SETTING_ENTRY
+{
+    LPCWSTR m_name;         // the value name (ASCII)
+    SETTING_TYPE m_type;
+    INT SETTINGS::*m_int;                   // SETTING_INT and SETTING_BOOL
+    DWORD SETTINGS::*m_dword;               // SETTING_DWORD
+    std::wstring SETTINGS::*m_string;       // SETTING_STRING
+    SETTINGS::list_type SETTINGS::*m_list;  // SETTING_LIST
+    DWORD m_default;        // the value, or the string ID of SETTING_STRING
+    INT m_ctrl;             // the control ID in the settings dialog, or zero
+    DWORD m_flags;
+};
+
+// the settings schema
+extern const SETTING_ENTRY g_setting_entries[];
+extern const size_t g_setting_count;
+
+void ShowSettingsDlg(HINSTANCE hInst, HWND hwnd, const std::wstring& strCurPage);
+std::wstring GetSettingsFilePath(LPCWSTR filename);
+std::wstring GetProbeStamp(DWORD emulation);
+
+#endif  // ndef SETTINGS_HPP_
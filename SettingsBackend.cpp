@@ -0,0 +1,822 @@
+// SettingsBackend.cpp --- SimpleBrowser settings storage
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SettingsBackend.hpp"
+#include "Settings.hpp"
+#include "SettingsSerializer.hpp"
+#include <shlwapi.h>
+#include <strsafe.h>
+#include <process.h>
+#include <io.h>
+#include <cstdio>
+#include <cstring>
+
+//////////////////////////////////////////////////////////////////////////////
+// MSettingsCheckpoint
+
+// "SBCK" + sequence number + payload size + CRC-32 of payload, then payload
+static const char s_szCheckpointMagic[] = "SBCK";
+#define CHECKPOINT_HEADER_SIZE  16
+
+static DWORD DoCrc32(const void *pv, size_t size)
+{
+    // the save worker and the UI thread call it. 0: none, 1: filling, 2: ready
+    static DWORD s_table[256];
+    static volatile LONG s_nInit = 0;
+    if (s_nInit != 2)
+    {
+        if (InterlockedCompareExchange(&s_nInit, 1, 0) == 0)
+        {
+            for (DWORD i = 0; i < 256; ++i)
+            {
+                DWORD crc = i;
+                for (INT k = 0; k < 8; ++k)
+                    crc = (crc & 1) ? (0xEDB88320 ^ (crc >> 1)) : (crc >> 1);
+                s_table[i] = crc;
+            }
+            InterlockedExchange(&s_nInit, 2);
+        }
+        else
+        {
+            while (s_nInit != 2)
+                Sleep(0);
+        }
+    }
+
+    const BYTE *pb = (const BYTE *)pv;
+    DWORD crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; ++i)
+    {
+        crc = s_table[(crc ^ pb[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+MSettingsCheckpoint::MSettingsCheckpoint(const std::wstring& path)
+    : m_path(path), m_seq(0)
+{
+    // one mutex per file. The name can't have backslashes.
+    std::wstring key = path;
+    if (key.size())
+        CharLowerBuffW(&key[0], DWORD(key.size()));
+    WCHAR szName[64];
+    StringCbPrintfW(szName, sizeof(szName), L"SimpleBrowser.Checkpoint.%08lX",
+                    DoCrc32(key.c_str(), key.size() * sizeof(WCHAR)));
+    m_hMutex = CreateMutexW(NULL, FALSE, szName);
+}
+
+MSettingsCheckpoint::~MSettingsCheckpoint()
+{
+    if (m_hMutex)
+        CloseHandle(m_hMutex);
+}
+
+void MSettingsCheckpoint::Lock()
+{
+    // WAIT_ABANDONED: the owner died. The files are still consistent.
+    if (m_hMutex)
+        WaitForSingleObject(m_hMutex, INFINITE);
+}
+
+void MSettingsCheckpoint::Unlock()
+{
+    if (m_hMutex)
+        ReleaseMutex(m_hMutex);
+}
+
+DWORD MSettingsCheckpoint::GetSequence() const
+{
+    return m_seq;
+}
+
+// odd sequence numbers go to the B slot
+std::wstring MSettingsCheckpoint::DoGetSlotPath(DWORD seq) const
+{
+    if (seq & 1)
+        return m_path + L".b";
+    return m_path;
+}
+
+BOOL MSettingsCheckpoint::DoReadSlot(const std::wstring& path, std::string& data, DWORD& seq) const
+{
+    FILE *fp = _wfopen(path.c_str(), L"rb");
+    if (!fp)
+        return FALSE;
+
+    std::string file;
+    char buf[4096];
+    while (size_t count = fread(buf, 1, sizeof(buf), fp))
+    {
+        file.append(buf, count);
+    }
+    fclose(fp);
+
+    if (file.size() < CHECKPOINT_HEADER_SIZE || memcmp(&file[0], s_szCheckpointMagic, 4) != 0)
+        return FALSE;
+
+    DWORD size, crc;
+    memcpy(&seq, &file[4], sizeof(DWORD));
+    memcpy(&size, &file[8], sizeof(DWORD));
+    memcpy(&crc, &file[12], sizeof(DWORD));
+    if (file.size() - CHECKPOINT_HEADER_SIZE != size ||
+        DoCrc32(&file[CHECKPOINT_HEADER_SIZE], size) != crc)
+    {
+        printf("MSettingsCheckpoint: %ls is broken\n", path.c_str());
+        return FALSE;
+    }
+
+    data = file.substr(CHECKPOINT_HEADER_SIZE);
+    return TRUE;
+}
+
+BOOL MSettingsCheckpoint::Read(std::string& data)
+{
+    std::string data_a, data_b;
+    DWORD seq_a = 0, seq_b = 0;
+    Lock();
+    BOOL bOK_a = DoReadSlot(DoGetSlotPath(0), data_a, seq_a);
+    BOOL bOK_b = DoReadSlot(DoGetSlotPath(1), data_b, seq_b);
+    Unlock();
+
+    if (bOK_a && (!bOK_b || seq_a > seq_b))
+    {
+        m_seq = seq_a;
+        data.swap(data_a);
+        return TRUE;
+    }
+    if (bOK_b)
+    {
+        m_seq = seq_b;
+        data.swap(data_b);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+BOOL MSettingsCheckpoint::Write(const std::string& data)
+{
+    Lock();
+
+    // another process may have written a newer one
+    std::string dummy;
+    DWORD seq = m_seq, seq_slot;
+    if (DoReadSlot(DoGetSlotPath(0), dummy, seq_slot) && seq < seq_slot)
+        seq = seq_slot;
+    if (DoReadSlot(DoGetSlotPath(1), dummy, seq_slot) && seq < seq_slot)
+        seq = seq_slot;
+    ++seq;
+
+    DWORD size = DWORD(data.size());
+    DWORD crc = DoCrc32(data.c_str(), data.size());
+
+    std::string file(s_szCheckpointMagic, 4);
+    file.append((const char *)&seq, sizeof(DWORD));
+    file.append((const char *)&size, sizeof(DWORD));
+    file.append((const char *)&crc, sizeof(DWORD));
+    file += data;
+
+    // the temporary file is per process
+    WCHAR szSuffix[32];
+    StringCbPrintfW(szSuffix, sizeof(szSuffix), L".%lu.tmp", GetCurrentProcessId());
+    std::wstring slot = DoGetSlotPath(seq);
+    std::wstring temp = slot + szSuffix;
+
+    FILE *fp = _wfopen(temp.c_str(), L"wb");
+    if (!fp)
+    {
+        Unlock();
+        return FALSE;
+    }
+
+    BOOL bOK = (fwrite(file.c_str(), file.size(), 1, fp) == 1);
+    if (fflush(fp) != 0 || _commit(_fileno(fp)) != 0)
+        bOK = FALSE;
+    if (fclose(fp) != 0)
+        bOK = FALSE;
+
+    if (bOK)
+    {
+        bOK = MoveFileExW(temp.c_str(), slot.c_str(),
+                          MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+    }
+    if (!bOK)
+    {
+        DeleteFileW(temp.c_str());
+        Unlock();
+        return FALSE;
+    }
+
+    m_seq = seq;
+    Unlock();
+    return TRUE;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// MRegistrySettings
+
+// "URLOrder": the slot numbers in the list order
+static BOOL DoLoadOrder(HKEY hApp, LPCWSTR name, std::vector<DWORD>& order)
+{
+    WCHAR szName[64];
+    StringCbPrintfW(szName, sizeof(szName), L"%sOrder", name);
+
+    order.clear();
+    DWORD cb = 0, type;
+    if (RegQueryValueEx(hApp, szName, NULL, &type, NULL, &cb) || type != REG_BINARY)
+        return FALSE;
+
+    order.resize(cb / sizeof(DWORD));
+    if (order.size() &&
+        RegQueryValueEx(hApp, szName, NULL, NULL, (LPBYTE)&order[0], &cb))
+    {
+        order.clear();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void DoSaveOrder(HKEY hApp, LPCWSTR name, const std::vector<DWORD>& order)
+{
+    WCHAR szName[64];
+    StringCbPrintfW(szName, sizeof(szName), L"%sOrder", name);
+
+    DWORD cb = DWORD(order.size() * sizeof(DWORD));
+    RegSetValueEx(hApp, szName, 0, REG_BINARY, (order.size() ? (LPBYTE)&order[0] : NULL), cb);
+
+    // the old layout is gone
+    StringCbPrintfW(szName, sizeof(szName), L"%sCount", name);
+    RegDeleteValue(hApp, szName);
+}
+
+static void DoSaveSlot(HKEY hApp, LPCWSTR name, DWORD slot, const std::wstring& str)
+{
+    WCHAR szName[64];
+    StringCbPrintfW(szName, sizeof(szName), L"%s%lu", name, slot);
+
+    DWORD cb = DWORD((str.size() + 1) * sizeof(WCHAR));
+    RegSetValueEx(hApp, szName, 0, REG_SZ, (LPBYTE)str.c_str(), cb);
+}
+
+static void DoDeleteSlot(HKEY hApp, LPCWSTR name, DWORD slot)
+{
+    WCHAR szName[64];
+    StringCbPrintfW(szName, sizeof(szName), L"%s%lu", name, slot);
+    RegDeleteValue(hApp, szName);
+}
+
+// The items kept from the old list stay in their slots. The new items
+// reuse the freed slots or take new ones, and the order is one value.
+// Returns the number of the values written.
+static DWORD DoSaveList(HKEY hApp, LPCWSTR name, const SETTINGS::list_type& list,
+                        const SETTINGS::list_type& old, const std::vector<DWORD>& old_slots,
+                        std::vector<DWORD>& slots, BOOL bAll)
+{
+    DWORD nWrites = 0;
+
+    if (bAll)
+    {
+        // the registry is unknown. Clear the old items of both layouts
+        std::vector<DWORD> order;
+        if (!DoLoadOrder(hApp, name, order))
+        {
+            WCHAR szCountName[64];
+            StringCbPrintfW(szCountName, sizeof(szCountName), L"%sCount", name);
+
+            DWORD count = 0, cb = sizeof(count);
+            RegQueryValueEx(hApp, szCountName, NULL, NULL, (LPBYTE)&count, &cb);
+            for (DWORD k = 0; k < count; ++k)
+                order.push_back(k);
+        }
+        for (size_t k = 0; k < order.size(); ++k)
+        {
+            if (order[k] >= list.size())
+                DoDeleteSlot(hApp, name, order[k]);
+        }
+
+        slots.clear();
+        for (DWORD k = 0; k < list.size(); ++k)
+        {
+            DoSaveSlot(hApp, name, k, list[k]);
+            slots.push_back(k);
+            ++nWrites;
+        }
+        DoSaveOrder(hApp, name, slots);
+        return nWrites + 1;
+    }
+
+    // the slots of the old items
+    std::multimap<std::wstring, DWORD> old_items;
+    std::vector<bool> used;
+    for (size_t k = 0; k < old.size() && k < old_slots.size(); ++k)
+    {
+        old_items.insert(std::make_pair(old[k], old_slots[k]));
+        if (used.size() <= old_slots[k])
+            used.resize(old_slots[k] + 1, false);
+        used[old_slots[k]] = true;
+    }
+
+    // keep the slots of the same items
+    const DWORD NO_SLOT = 0xFFFFFFFF;
+    slots.assign(list.size(), NO_SLOT);
+    for (size_t k = 0; k < list.size(); ++k)
+    {
+        std::multimap<std::wstring, DWORD>::iterator it = old_items.find(list[k]);
+        if (it != old_items.end())
+        {
+            slots[k] = it->second;
+            old_items.erase(it);
+        }
+    }
+
+    // the freed slots
+    std::vector<DWORD> freed;
+    std::multimap<std::wstring, DWORD>::iterator it, end = old_items.end();
+    for (it = old_items.begin(); it != end; ++it)
+    {
+        freed.push_back(it->second);
+    }
+
+    // write the new items
+    DWORD next = 0;
+    for (size_t k = 0; k < list.size(); ++k)
+    {
+        if (slots[k] != NO_SLOT)
+            continue;
+
+        if (freed.size())
+        {
+            slots[k] = freed.back();
+            freed.pop_back();
+        }
+        else
+        {
+            while (next < used.size() && used[next])
+                ++next;
+            slots[k] = next++;
+        }
+        DoSaveSlot(hApp, name, slots[k], list[k]);
+        ++nWrites;
+    }
+
+    for (size_t k = 0; k < freed.size(); ++k)
+    {
+        DoDeleteSlot(hApp, name, freed[k]);
+        ++nWrites;
+    }
+
+    if (slots != old_slots)
+    {
+        DoSaveOrder(hApp, name, slots);
+        ++nWrites;
+    }
+    return nWrites;
+}
+
+MRegistrySettings::MRegistrySettings()
+    : m_checkpoint(GetSettingsFilePath(L"Settings.chk")), m_bSaved(FALSE)
+{
+}
+
+BOOL MRegistrySettings::Load(SETTINGS& settings)
+{
+    static const TCHAR s_szSubKey[] =
+        TEXT("SOFTWARE\\Katayama Hirofumi MZ\\SimpleBrowser");
+
+    BOOL bOK = FALSE;
+    DWORD checkpoint = 0;
+    HKEY hApp = NULL;
+
+    // another process may be saving
+    m_checkpoint.Lock();
+
+    RegOpenKeyEx(HKEY_CURRENT_USER, s_szSubKey, 0, KEY_READ, &hApp);
+    if (hApp)
+    {
+        WCHAR szText[MAX_PATH + 64];
+        WCHAR szName[64];
+        DWORD value, cb;
+
+        for (size_t i = 0; i < g_setting_count; ++i)
+        {
+            const SETTING_ENTRY& entry = g_setting_entries[i];
+            if (entry.m_flags & SETTING_TRANSIENT)
+                continue;
+
+            switch (entry.m_type)
+            {
+            case SETTING_INT:
+            case SETTING_BOOL:
+            case SETTING_DWORD:
+                value = settings.GetDword(entry);
+                cb = sizeof(value);
+                RegQueryValueEx(hApp, entry.m_name, NULL, NULL, (LPBYTE)&value, &cb);
+                settings.SetDword(entry, value);
+                break;
+
+            case SETTING_STRING:
+                cb = sizeof(szText);
+                if (!RegQueryValueEx(hApp, entry.m_name, NULL, NULL, (LPBYTE)szText, &cb))
+                {
+                    szText[ARRAYSIZE(szText) - 1] = 0;
+                    settings.String(entry) = szText;
+                }
+                break;
+
+            case SETTING_LIST:
+                {
+                    SETTINGS::list_type& list = settings.List(entry);
+                    slots_type& slots = m_slots[entry.m_name];
+                    slots.clear();
+
+                    slots_type order;
+                    if (!DoLoadOrder(hApp, entry.m_name, order))
+                    {
+                        // the old layout: "URLCount" and "URL0", "URL1", ...
+                        DWORD count = 0;
+                        StringCbPrintfW(szName, sizeof(szName), L"%sCount", entry.m_name);
+                        cb = sizeof(count);
+                        RegQueryValueEx(hApp, szName, NULL, NULL, (LPBYTE)&count, &cb);
+                        for (DWORD k = 0; k < count; ++k)
+                            order.push_back(k);
+                    }
+
+                    for (size_t k = 0; k < order.size(); ++k)
+                    {
+                        StringCbPrintfW(szName, sizeof(szName), L"%s%lu", entry.m_name, order[k]);
+
+                        cb = sizeof(szText);
+                        if (!RegQueryValueEx(hApp, szName, NULL, NULL, (LPBYTE)szText, &cb))
+                        {
+                            szText[ARRAYSIZE(szText) - 1] = 0;
+                            StrTrimW(szText, L" \t\n\r\f\v");
+                            list.push_back(szText);
+                            slots.push_back(order[k]);
+                        }
+                    }
+                }
+                break;
+            }
+        }
+
+        cb = sizeof(checkpoint);
+        RegQueryValueEx(hApp, L"Checkpoint", NULL, NULL, (LPBYTE)&checkpoint, &cb);
+
+        bOK = TRUE;
+        RegCloseKey(hApp);
+    }
+
+    // the process was killed while saving to the registry?
+    std::string data;
+    if (m_checkpoint.Read(data) && m_checkpoint.GetSequence() > checkpoint)
+    {
+        printf("MRegistrySettings::Load: checkpoint %lu > %lu\n",
+               m_checkpoint.GetSequence(), checkpoint);
+        if (MFileSettings::Deserialize(settings, data))
+            bOK = TRUE;
+
+        // the registry doesn't match anything we know
+        m_bSaved = FALSE;
+    }
+    else if (bOK)
+    {
+        m_saved = settings;
+        MFileSettings::Serialize(m_saved, m_saved_data);
+        m_bSaved = TRUE;
+    }
+
+    m_checkpoint.Unlock();
+    return bOK;
+}
+
+BOOL MRegistrySettings::Save(const SETTINGS& settings)
+{
+    std::string data;
+    MFileSettings::Serialize(settings, data);
+    if (m_bSaved && data == m_saved_data)
+        return TRUE;    // nothing changed
+
+    // the checkpoint and the registry are written as one
+    m_checkpoint.Lock();
+    m_checkpoint.Write(data);
+
+    HKEY hSoftware = NULL;
+    HKEY hCompany = NULL;
+    HKEY hApp = NULL;
+    BOOL bOK = FALSE;
+    RegCreateKeyEx(HKEY_CURRENT_USER, TEXT("SOFTWARE"), 0, NULL, 0,
+                   KEY_ALL_ACCESS, NULL, &hSoftware, NULL);
+    if (hSoftware)
+    {
+        RegCreateKeyEx(hSoftware, TEXT("Katayama Hirofumi MZ"), 0, NULL, 0,
+                       KEY_ALL_ACCESS, NULL, &hCompany, NULL);
+        if (hCompany)
+        {
+            RegCreateKeyEx(hCompany, TEXT("SimpleBrowser"), 0, NULL, 0,
+                           KEY_ALL_ACCESS, NULL, &hApp, NULL);
+            if (hApp)
+            {
+                // without the last saved state, everything is written
+                BOOL bAll = !m_bSaved;
+                DWORD value, cb, nWrites = 0;
+
+                for (size_t i = 0; i < g_setting_count; ++i)
+                {
+                    const SETTING_ENTRY& entry = g_setting_entries[i];
+                    if (entry.m_flags & SETTING_TRANSIENT)
+                        continue;
+
+                    if (entry.m_type == SETTING_LIST)
+                    {
+                        slots_type& slots = m_slots[entry.m_name];
+                        slots_type new_slots;
+                        nWrites += DoSaveList(hApp, entry.m_name, settings.List(entry),
+                                              m_saved.List(entry), slots, new_slots, bAll);
+                        slots.swap(new_slots);
+                        continue;
+                    }
+
+                    if (!bAll && settings.IsSame(m_saved, entry))
+                        continue;
+
+                    if (entry.m_type == SETTING_STRING)
+                    {
+                        const std::wstring& str = settings.String(entry);
+                        cb = DWORD((str.size() + 1) * sizeof(WCHAR));
+                        RegSetValueEx(hApp, entry.m_name, 0, REG_SZ, (LPBYTE)str.c_str(), cb);
+                    }
+                    else
+                    {
+                        value = settings.GetDword(entry);
+                        cb = DWORD(sizeof(value));
+                        RegSetValueEx(hApp, entry.m_name, 0, REG_DWORD, (LPBYTE)&value, cb);
+                    }
+                    ++nWrites;
+                }
+
+                // the registry is complete up to this checkpoint
+                value = m_checkpoint.GetSequence();
+                cb = DWORD(sizeof(value));
+                RegSetValueEx(hApp, L"Checkpoint", 0, REG_DWORD, (LPBYTE)&value, cb);
+                ++nWrites;
+
+                printf("MRegistrySettings::Save: %lu values written\n", nWrites);
+
+                m_saved = settings;
+                m_saved_data.swap(data);
+                m_bSaved = TRUE;
+
+                bOK = TRUE;
+                RegCloseKey(hApp);
+            }
+            RegCloseKey(hCompany);
+        }
+        RegCloseKey(hSoftware);
+    }
+
+    m_checkpoint.Unlock();
+    return bOK;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// MFileSettings
+
+// the stored entries of the schema as the fields of the serializer
+struct SETTINGS_SCHEMA
+{
+    std::vector<SERIAL_FIELD> m_fields;
+    std::vector<const SETTING_ENTRY *> m_entries;
+
+    SETTINGS_SCHEMA()
+    {
+        for (size_t i = 0; i < g_setting_count; ++i)
+        {
+            const SETTING_ENTRY& entry = g_setting_entries[i];
+            if (entry.m_flags & SETTING_TRANSIENT)
+                continue;
+
+            SERIAL_FIELD field;
+            field.m_name = entry.m_name;
+            switch (entry.m_type)
+            {
+            case SETTING_STRING:
+                field.m_kind = SERIAL_STRING;
+                break;
+            case SETTING_LIST:
+                field.m_kind = SERIAL_LIST;
+                break;
+            default:
+                field.m_kind = SERIAL_NUMBER;
+                break;
+            }
+            m_fields.push_back(field);
+            m_entries.push_back(&entry);
+        }
+    }
+};
+
+static const SETTINGS_SCHEMA& DoGetSchema()
+{
+    static const SETTINGS_SCHEMA s_schema;
+    return s_schema;
+}
+
+// SETTINGS by the index of SETTINGS_SCHEMA
+class MSettingsValues : public MSerialValues
+{
+public:
+    MSettingsValues(const SETTINGS_SCHEMA& schema, SETTINGS& settings)
+        : m_schema(schema), m_settings(settings)
+    {
+    }
+
+    virtual unsigned long GetNumber(size_t i) const
+    {
+        return m_settings.GetDword(*m_schema.m_entries[i]);
+    }
+    virtual void SetNumber(size_t i, unsigned long value)
+    {
+        m_settings.SetDword(*m_schema.m_entries[i], DWORD(value));
+    }
+    virtual const std::wstring& GetString(size_t i) const
+    {
+        return m_settings.String(*m_schema.m_entries[i]);
+    }
+    virtual const list_type& GetList(size_t i) const
+    {
+        return m_settings.List(*m_schema.m_entries[i]);
+    }
+    virtual void SetString(size_t i, std::wstring& value)
+    {
+        m_settings.String(*m_schema.m_entries[i]).swap(value);
+    }
+    virtual void SetList(size_t i, list_type& value)
+    {
+        m_settings.List(*m_schema.m_entries[i]).swap(value);
+    }
+
+protected:
+    const SETTINGS_SCHEMA& m_schema;
+    SETTINGS& m_settings;
+};
+
+MFileSettings::MFileSettings(const std::wstring& path) : m_checkpoint(path)
+{
+}
+
+/*static*/ void MFileSettings::Serialize(const SETTINGS& settings, std::string& data)
+{
+    const SETTINGS_SCHEMA& schema = DoGetSchema();
+    MSettingsSerializer serializer(&schema.m_fields[0], schema.m_fields.size());
+
+    // it only reads the settings
+    MSettingsValues values(schema, const_cast<SETTINGS&>(settings));
+    serializer.Serialize(values, data);
+}
+
+/*static*/ BOOL MFileSettings::Deserialize(SETTINGS& settings, const std::string& data)
+{
+    const SETTINGS_SCHEMA& schema = DoGetSchema();
+    MSettingsSerializer serializer(&schema.m_fields[0], schema.m_fields.size());
+    MSettingsValues values(schema, settings);
+    return serializer.Deserialize(values, data);
+}
+
+BOOL MFileSettings::Load(SETTINGS& settings)
+{
+    std::string data;
+    if (!m_checkpoint.Read(data))
+        return FALSE;
+
+    if (!Deserialize(settings, data))
+        return FALSE;
+
+    m_saved_data.swap(data);
+    return TRUE;
+}
+
+BOOL MFileSettings::Save(const SETTINGS& settings)
+{
+    std::string data;
+    Serialize(settings, data);
+    if (data == m_saved_data)
+        return TRUE;    // nothing changed
+
+    if (!m_checkpoint.Write(data))
+        return FALSE;
+
+    m_saved_data.swap(data);
+    return TRUE;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOL IsPortableMode()
+{
+    static INT s_portable = -1;
+    if (s_portable == -1)
+    {
+        WCHAR szPath[MAX_PATH];
+        GetModuleFileNameW(NULL, szPath, ARRAYSIZE(szPath));
+        PathRemoveFileSpecW(szPath);
+        PathAppendW(szPath, PORTABLE_SETTINGS_FILE);
+        s_portable = PathFileExistsW(szPath);
+    }
+    return s_portable;
+}
+
+MSettingsBackend *GetSettingsBackend()
+{
+    if (IsPortableMode())
+    {
+        static MFileSettings s_file(GetSettingsFilePath(PORTABLE_SETTINGS_FILE));
+        return &s_file;
+    }
+
+    static MRegistrySettings s_registry;
+    return &s_registry;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// the background saving
+
+class MSettingsWriter
+{
+public:
+    MSettingsWriter() : m_pending(NULL), m_hThread(NULL), m_bRunning(FALSE)
+    {
+        InitializeCriticalSection(&m_lock);
+    }
+    ~MSettingsWriter()
+    {
+        Wait();
+        if (m_hThread)
+            CloseHandle(m_hThread);
+        delete m_pending;
+        DeleteCriticalSection(&m_lock);
+    }
+
+    void Post(SETTINGS *pSettings)
+    {
+        EnterCriticalSection(&m_lock);
+        delete m_pending;   // superseded by the newer snapshot
+        m_pending = pSettings;
+        if (!m_bRunning)
+        {
+            if (m_hThread)
+                CloseHandle(m_hThread);
+            m_hThread = (HANDLE)_beginthreadex(NULL, 0, ThreadProc, this, 0, NULL);
+            m_bRunning = (m_hThread != NULL);
+        }
+        LeaveCriticalSection(&m_lock);
+    }
+
+    void Wait()
+    {
+        EnterCriticalSection(&m_lock);
+        HANDLE hThread = m_bRunning ? m_hThread : NULL;
+        LeaveCriticalSection(&m_lock);
+
+        if (hThread)
+            WaitForSingleObject(hThread, INFINITE);
+    }
+
+protected:
+    CRITICAL_SECTION m_lock;
+    SETTINGS *m_pending;
+    HANDLE m_hThread;
+    BOOL m_bRunning;
+
+    static unsigned __stdcall ThreadProc(void *arg)
+    {
+        MSettingsWriter *pWriter = (MSettingsWriter *)arg;
+        for (;;)
+        {
+            EnterCriticalSection(&pWriter->m_lock);
+            SETTINGS *pSettings = pWriter->m_pending;
+            pWriter->m_pending = NULL;
+            if (!pSettings)
+                pWriter->m_bRunning = FALSE;
+            LeaveCriticalSection(&pWriter->m_lock);
+
+            if (!pSettings)
+                break;
+
+            GetSettingsBackend()->Save(*pSettings);
+            delete pSettings;
+        }
+        return 0;
+    }
+};
+static MSettingsWriter s_writer;
+
+void SaveSettingsAsync(const SETTINGS& settings)
+{
+    s_writer.Post(new SETTINGS(settings));
+}
+
+void WaitForSettingsSave()
+{
+    s_writer.Wait();
+}
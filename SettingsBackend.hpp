@@ -0,0 +1,108 @@
+// SettingsBackend.hpp --- SimpleBrowser settings storage
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef SETTINGS_BACKEND_HPP_
+#define SETTINGS_BACKEND_HPP_
+
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+#include <string>
+#include <vector>
+#include <map>
+#include "Settings.hpp"
+
+// the settings file next to the program enables the portable mode
+#define PORTABLE_SETTINGS_FILE  L"SimpleBrowser.dat"
+
+// crash-safe storage of a blob in two alternating files.
+// Each file has a sequence number and a CRC-32, and it's replaced atomically
+// by renaming a temporary file, so a torn write leaves the other one intact.
+// The processes share the files. A named mutex serializes them, and the next
+// sequence number comes from the files, not from the last one we wrote.
+class MSettingsCheckpoint
+{
+public:
+    MSettingsCheckpoint(const std::wstring& path);
+    ~MSettingsCheckpoint();
+
+    BOOL Read(std::string& data);
+    BOOL Write(const std::string& data);
+    DWORD GetSequence() const;
+
+    // hold it to keep the files and what they describe consistent.
+    // Read and Write lock it by themselves.
+    void Lock();
+    void Unlock();
+
+protected:
+    std::wstring m_path;
+    DWORD m_seq;
+    HANDLE m_hMutex;
+
+    std::wstring DoGetSlotPath(DWORD seq) const;
+    BOOL DoReadSlot(const std::wstring& path, std::string& data, DWORD& seq) const;
+};
+
+class MSettingsBackend
+{
+public:
+    virtual ~MSettingsBackend() { }
+
+    virtual BOOL Load(SETTINGS& settings) = 0;
+    virtual BOOL Save(const SETTINGS& settings) = 0;
+};
+
+// HKEY_CURRENT_USER\SOFTWARE\Katayama Hirofumi MZ\SimpleBrowser
+// A checkpoint file is written before the registry. If the registry was
+// left half-written, the newer checkpoint wins on loading.
+// Only the values changed since the last load/save are written.
+// An item of a list stays in its slot ("URL0", "URL1", ...), and "URLOrder"
+// has the slot numbers in the list order, so adding, moving or removing an
+// item writes a few values whatever the length of the list.
+class MRegistrySettings : public MSettingsBackend
+{
+public:
+    MRegistrySettings();
+
+    virtual BOOL Load(SETTINGS& settings);
+    virtual BOOL Save(const SETTINGS& settings);
+
+protected:
+    MSettingsCheckpoint m_checkpoint;
+    SETTINGS m_saved;           // the state in the registry
+    std::string m_saved_data;   // serialized m_saved
+    BOOL m_bSaved;
+
+    // the slots of the items of m_saved's lists, by the entry name
+    typedef std::vector<DWORD> slots_type;
+    std::map<std::wstring, slots_type> m_slots;
+};
+
+// the whole settings in one binary file
+class MFileSettings : public MSettingsBackend
+{
+public:
+    MFileSettings(const std::wstring& path);
+
+    virtual BOOL Load(SETTINGS& settings);
+    virtual BOOL Save(const SETTINGS& settings);
+
+    // no I/O
+    static void Serialize(const SETTINGS& settings, std::string& data);
+    static BOOL Deserialize(SETTINGS& settings, const std::string& data);
+
+protected:
+    MSettingsCheckpoint m_checkpoint;
+    std::string m_saved_data;   // the last data in the file
+};
+
+BOOL IsPortableMode();
+MSettingsBackend *GetSettingsBackend();
+
+// saves a snapshot of the settings in a worker thread
+void SaveSettingsAsync(const SETTINGS& settings);
+void WaitForSettingsSave();
+
+#endif  // ndef SETTINGS_BACKEND_HPP_
@@ -0,0 +1,185 @@
+// SettingsSerializer.cpp --- the binary format of the settings
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "SettingsSerializer.hpp"
+#include "UTF8Codec.hpp"
+#include <cstring>
+#include <cwchar>
+
+// NOTE: This file doesn't depend on Win32 API.
+
+static const char s_szMagic[] = "SBST";
+#define SETTINGS_VERSION    1
+
+static void DoWriteVarint(std::string& buf, unsigned long value)
+{
+    while (value >= 0x80)
+    {
+        buf += char((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    buf += char(value);
+}
+
+static bool DoReadVarint(const unsigned char *& pb, const unsigned char *end,
+                         unsigned long& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (pb >= end)
+            return false;
+        unsigned char b = *pb++;
+        value |= (unsigned long)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return value <= 0xFFFFFFFF;
+    }
+    return false;
+}
+
+// utf8 is the buffer of the conversion
+static void DoWriteString(std::string& buf, const std::wstring& str, std::string& utf8)
+{
+    EncodeUTF8(str.c_str(), str.size(), utf8);
+    DoWriteVarint(buf, (unsigned long)utf8.size());
+    buf += utf8;
+}
+
+static bool DoReadString(const unsigned char *& pb, const unsigned char *end,
+                         std::wstring& str)
+{
+    unsigned long len;
+    if (!DoReadVarint(pb, end, len) || (unsigned long)(end - pb) < len)
+        return false;
+    str = UTF8ToWide((const char *)pb, len);
+    pb += len;
+    return true;
+}
+
+static void DoWriteName(std::string& buf, SERIAL_KIND kind, const wchar_t *name)
+{
+    buf += char(kind);
+    size_t len = std::wcslen(name);
+    DoWriteVarint(buf, (unsigned long)len);
+    for (size_t i = 0; i < len; ++i)
+    {
+        buf += char(name[i]);
+    }
+}
+
+MSettingsSerializer::MSettingsSerializer(const SERIAL_FIELD *fields, size_t count)
+    : m_fields(fields), m_count(count)
+{
+}
+
+// returns m_count if not found
+size_t MSettingsSerializer::DoFindField(const unsigned char *name, size_t len) const
+{
+    for (size_t i = 0; i < m_count; ++i)
+    {
+        const wchar_t *field = m_fields[i].m_name;
+        size_t k;
+        for (k = 0; k < len && field[k]; ++k)
+        {
+            if (wchar_t(name[k]) != field[k])
+                break;
+        }
+        if (k == len && field[k] == 0)
+            return i;
+    }
+    return m_count;
+}
+
+void MSettingsSerializer::Serialize(const MSerialValues& values, std::string& data) const
+{
+    data.assign(s_szMagic, 4);
+    data += char(SETTINGS_VERSION);
+
+    std::string utf8;
+    for (size_t i = 0; i < m_count; ++i)
+    {
+        const SERIAL_FIELD& field = m_fields[i];
+        DoWriteName(data, field.m_kind, field.m_name);
+        switch (field.m_kind)
+        {
+        case SERIAL_NUMBER:
+            DoWriteVarint(data, values.GetNumber(i) & 0xFFFFFFFF);
+            break;
+        case SERIAL_STRING:
+            DoWriteString(data, values.GetString(i), utf8);
+            break;
+        case SERIAL_LIST:
+            {
+                const MSerialValues::list_type& list = values.GetList(i);
+                DoWriteVarint(data, (unsigned long)list.size());
+                for (size_t k = 0; k < list.size(); ++k)
+                {
+                    DoWriteString(data, list[k], utf8);
+                }
+            }
+            break;
+        }
+    }
+}
+
+bool MSettingsSerializer::Deserialize(MSerialValues& values, const std::string& data) const
+{
+    const unsigned char *pb = (const unsigned char *)data.c_str();
+    const unsigned char *end = pb + data.size();
+    if (data.size() < 5 || std::memcmp(pb, s_szMagic, 4) != 0 || pb[4] != SETTINGS_VERSION)
+        return false;
+    pb += 5;
+
+    std::wstring str;
+    while (pb < end)
+    {
+        unsigned char kind = *pb++;
+
+        unsigned long len;
+        if (!DoReadVarint(pb, end, len) || (unsigned long)(end - pb) < len)
+            return false;
+
+        // the field must match both the name and the kind
+        size_t i = DoFindField(pb, len);
+        pb += len;
+        if (i < m_count && m_fields[i].m_kind != kind)
+            i = m_count;
+
+        unsigned long value;
+        switch (kind)
+        {
+        case SERIAL_NUMBER:
+            if (!DoReadVarint(pb, end, value))
+                return false;
+            if (i < m_count)
+                values.SetNumber(i, value);
+            break;
+        case SERIAL_STRING:
+            if (!DoReadString(pb, end, str))
+                return false;
+            if (i < m_count)
+                values.SetString(i, str);
+            break;
+        case SERIAL_LIST:
+            {
+                MSerialValues::list_type list;
+                if (!DoReadVarint(pb, end, value))
+                    return false;
+                for (unsigned long k = 0; k < value; ++k)
+                {
+                    if (!DoReadString(pb, end, str))
+                        return false;
+                    list.push_back(str);
+                }
+                if (i < m_count)
+                    values.SetList(i, list);
+            }
+            break;
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,67 @@
+// SettingsSerializer.hpp --- the binary format of the settings
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef SETTINGS_SERIALIZER_HPP_
+#define SETTINGS_SERIALIZER_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// NOTE: This file doesn't depend on Win32 API.
+
+// the kind of a stored field. It's the record type in the data.
+enum SERIAL_KIND
+{
+    SERIAL_NUMBER = 1,
+    SERIAL_STRING = 2,
+    SERIAL_LIST = 3
+};
+
+struct SERIAL_FIELD
+{
+    const wchar_t *m_name;  // ASCII
+    SERIAL_KIND m_kind;
+};
+
+// the values of the fields by the index of the schema
+class MSerialValues
+{
+public:
+    typedef std::vector<std::wstring> list_type;
+
+    virtual ~MSerialValues() { }
+
+    virtual unsigned long GetNumber(size_t i) const = 0;
+    virtual void SetNumber(size_t i, unsigned long value) = 0;
+    virtual const std::wstring& GetString(size_t i) const = 0;
+    virtual const list_type& GetList(size_t i) const = 0;
+
+    // they may swap the value out
+    virtual void SetString(size_t i, std::wstring& value) = 0;
+    virtual void SetList(size_t i, list_type& value) = 0;
+};
+
+// "SBST" + version, then the records of
+//     kind (1 byte) + name (varint length + ASCII) + value
+// The value is a varint (SERIAL_NUMBER), a varint length + UTF-8
+// (SERIAL_STRING), or a varint count + the strings (SERIAL_LIST).
+// The records of unknown names or of another kind are skipped, and the
+// fields without a record keep their values.
+class MSettingsSerializer
+{
+public:
+    MSettingsSerializer(const SERIAL_FIELD *fields, size_t count);
+
+    void Serialize(const MSerialValues& values, std::string& data) const;
+    bool Deserialize(MSerialValues& values, const std::string& data) const;
+
+protected:
+    const SERIAL_FIELD *m_fields;
+    size_t m_count;
+
+    size_t DoFindField(const unsigned char *name, size_t len) const;
+};
+
+#endif  // ndef SETTINGS_SERIALIZER_HPP_
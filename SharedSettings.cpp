@@ -0,0 +1,336 @@
+// SharedSettings.cpp --- settings shared by SimpleBrowser processes
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "SharedSettings.hpp"
+#include "SettingsBackend.hpp"
+#include "Settings.hpp"
+#include <strsafe.h>
+#include <process.h>
+#include <set>
+#include <cstdio>
+
+MSharedSettings g_shared_settings;
+
+#define SHARED_DATA_MAX     (SHARED_SETTINGS_SIZE - sizeof(SHARED_SETTINGS_HEADER))
+
+// the reader gives up if a writer doesn't finish
+#define SHARED_READ_RETRY   1000
+
+static void DoGetEventName(LPWSTR pszName, size_t cbName, DWORD pid)
+{
+    StringCbPrintfW(pszName, cbName, L"SimpleBrowser.SettingsChanged.%lu", pid);
+}
+
+// our additions first, and then their items except what we removed
+static void DoMergeList(SETTINGS::list_type& ours, const SETTINGS::list_type& base,
+                        const SETTINGS::list_type& theirs)
+{
+    if (ours == base)
+    {
+        ours = theirs;
+        return;
+    }
+    if (theirs == base)
+        return;
+
+    std::set<std::wstring> in_base(base.begin(), base.end());
+    std::set<std::wstring> in_ours(ours.begin(), ours.end());
+
+    SETTINGS::list_type merged;
+    std::set<std::wstring> done;
+    for (size_t i = 0; i < ours.size(); ++i)
+    {
+        if (in_base.count(ours[i]) == 0 && done.insert(ours[i]).second)
+            merged.push_back(ours[i]);
+    }
+    for (size_t i = 0; i < theirs.size(); ++i)
+    {
+        if (in_base.count(theirs[i]) && in_ours.count(theirs[i]) == 0)
+            continue;   // we removed it
+        if (done.insert(theirs[i]).second)
+            merged.push_back(theirs[i]);
+    }
+    ours.swap(merged);
+}
+
+// takes the entries that we didn't change since the base
+static void DoMerge(SETTINGS& ours, const SETTINGS& base, const SETTINGS& theirs)
+{
+    for (size_t i = 0; i < g_setting_count; ++i)
+    {
+        const SETTING_ENTRY& entry = g_setting_entries[i];
+        if (entry.m_flags & (SETTING_TRANSIENT | SETTING_LOCAL))
+            continue;
+
+        if (entry.m_type == SETTING_LIST)
+            DoMergeList(ours.List(entry), base.List(entry), theirs.List(entry));
+        else if (ours.IsSame(base, entry))
+            ours.Assign(theirs, entry);
+    }
+}
+
+MSharedSettings::MSharedSettings() :
+    m_hMapping(NULL),
+    m_hMutex(NULL),
+    m_hChanged(NULL),
+    m_hQuit(NULL),
+    m_hThread(NULL),
+    m_pHeader(NULL),
+    m_seq(0),
+    m_hwndNotify(NULL),
+    m_nCommandID(0)
+{
+}
+
+MSharedSettings::~MSharedSettings()
+{
+    Close();
+}
+
+BYTE *MSharedSettings::DoGetData() const
+{
+    return (BYTE *)(m_pHeader + 1);
+}
+
+BOOL MSharedSettings::Open(SETTINGS& settings, HWND hwndNotify, UINT nCommandID)
+{
+    m_hwndNotify = hwndNotify;
+    m_nCommandID = nCommandID;
+
+    m_hMutex = CreateMutexW(NULL, FALSE, L"SimpleBrowser.SettingsMutex");
+    if (!m_hMutex)
+        return FALSE;
+
+    WaitForSingleObject(m_hMutex, INFINITE);
+
+    m_hMapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                    0, SHARED_SETTINGS_SIZE, L"SimpleBrowser.Settings");
+    BOOL bExisted = (GetLastError() == ERROR_ALREADY_EXISTS);
+    if (m_hMapping)
+    {
+        m_pHeader = (SHARED_SETTINGS_HEADER *)MapViewOfFile(m_hMapping, FILE_MAP_ALL_ACCESS,
+                                                            0, 0, 0);
+    }
+    if (!m_pHeader)
+    {
+        ReleaseMutex(m_hMutex);
+        Close();
+        return FALSE;
+    }
+
+    // register this process to the notification
+    DWORD pid = GetCurrentProcessId();
+    WCHAR szName[64];
+    DoGetEventName(szName, sizeof(szName), pid);
+    m_hChanged = CreateEventW(NULL, FALSE, FALSE, szName);
+    for (INT i = 0; m_hChanged && i < SHARED_MAX_INSTANCES; ++i)
+    {
+        if (m_pHeader->m_pids[i] == 0)
+        {
+            m_pHeader->m_pids[i] = pid;
+            break;
+        }
+    }
+
+    ReleaseMutex(m_hMutex);
+
+    if (bExisted && m_pHeader->m_size)
+        Read(settings);
+    else
+        Write(settings);
+
+    if (m_hChanged)
+    {
+        m_hQuit = CreateEventW(NULL, TRUE, FALSE, NULL);
+        m_hThread = (HANDLE)_beginthreadex(NULL, 0, WatcherProc, this, 0, NULL);
+    }
+
+    return TRUE;
+}
+
+void MSharedSettings::Close()
+{
+    if (m_hThread)
+    {
+        SetEvent(m_hQuit);
+        WaitForSingleObject(m_hThread, INFINITE);
+        CloseHandle(m_hThread);
+        m_hThread = NULL;
+    }
+    if (m_hQuit)
+    {
+        CloseHandle(m_hQuit);
+        m_hQuit = NULL;
+    }
+
+    if (m_pHeader)
+    {
+        WaitForSingleObject(m_hMutex, INFINITE);
+        DWORD pid = GetCurrentProcessId();
+        for (INT i = 0; i < SHARED_MAX_INSTANCES; ++i)
+        {
+            if (m_pHeader->m_pids[i] == pid)
+                m_pHeader->m_pids[i] = 0;
+        }
+        ReleaseMutex(m_hMutex);
+
+        UnmapViewOfFile(m_pHeader);
+        m_pHeader = NULL;
+    }
+
+    if (m_hChanged)
+    {
+        CloseHandle(m_hChanged);
+        m_hChanged = NULL;
+    }
+    if (m_hMapping)
+    {
+        CloseHandle(m_hMapping);
+        m_hMapping = NULL;
+    }
+    if (m_hMutex)
+    {
+        CloseHandle(m_hMutex);
+        m_hMutex = NULL;
+    }
+}
+
+BOOL MSharedSettings::Read(SETTINGS& settings)
+{
+    if (!m_pHeader)
+        return FALSE;
+
+    std::string data;
+    LONG seq;
+    for (INT i = 0; ; ++i)
+    {
+        if (i >= SHARED_READ_RETRY)
+            return FALSE;
+
+        seq = m_pHeader->m_seq;
+        if (seq == m_seq)
+            return FALSE;   // not changed
+        if (seq & 1)
+        {
+            Sleep(0);   // being written
+            continue;
+        }
+
+        MemoryBarrier();
+        DWORD size = m_pHeader->m_size;
+        if (size > SHARED_DATA_MAX)
+            size = 0;
+        data.assign((const char *)DoGetData(), size);
+        MemoryBarrier();
+
+        if (m_pHeader->m_seq == seq)
+            break;
+    }
+
+    m_seq = seq;
+
+    SETTINGS shared = settings;
+    if (data.empty() || !MFileSettings::Deserialize(shared, data))
+        return FALSE;
+    m_base.swap(data);
+
+    for (size_t i = 0; i < g_setting_count; ++i)
+    {
+        const SETTING_ENTRY& entry = g_setting_entries[i];
+        if (!(entry.m_flags & SETTING_LOCAL))
+            settings.Assign(shared, entry);
+    }
+    return TRUE;
+}
+
+BOOL MSharedSettings::Write(SETTINGS& settings, BOOL *pbMerged)
+{
+    if (pbMerged)
+        *pbMerged = FALSE;
+    if (!m_pHeader)
+        return FALSE;
+
+    if (WaitForSingleObject(m_hMutex, INFINITE) == WAIT_ABANDONED)
+    {
+        // the last writer died while writing
+        if (m_pHeader->m_seq & 1)
+            InterlockedIncrement(&m_pHeader->m_seq);
+    }
+
+    // another process has written since our last Read/Write?
+    DWORD size = m_pHeader->m_size;
+    if (m_pHeader->m_seq != m_seq && size && size <= SHARED_DATA_MAX)
+    {
+        std::string data((const char *)DoGetData(), size);
+        SETTINGS base = settings, theirs = settings;
+        if (MFileSettings::Deserialize(base, m_base) &&
+            MFileSettings::Deserialize(theirs, data))
+        {
+            DoMerge(settings, base, theirs);
+            if (pbMerged)
+                *pbMerged = TRUE;
+        }
+    }
+
+    std::string data;
+    MFileSettings::Serialize(settings, data);
+    if (data.size() > SHARED_DATA_MAX)
+    {
+        ReleaseMutex(m_hMutex);
+        return FALSE;
+    }
+
+    if (m_pHeader->m_size != data.size() ||
+        memcmp(DoGetData(), data.c_str(), data.size()) != 0)
+    {
+        InterlockedIncrement(&m_pHeader->m_seq);
+        CopyMemory(DoGetData(), data.c_str(), data.size());
+        m_pHeader->m_size = DWORD(data.size());
+        m_seq = InterlockedIncrement(&m_pHeader->m_seq);
+
+        DoNotify();
+    }
+    else
+    {
+        m_seq = m_pHeader->m_seq;
+    }
+    m_base.swap(data);
+
+    ReleaseMutex(m_hMutex);
+    return TRUE;
+}
+
+// called while the mutex is owned
+void MSharedSettings::DoNotify()
+{
+    DWORD self = GetCurrentProcessId();
+    WCHAR szName[64];
+    for (INT i = 0; i < SHARED_MAX_INSTANCES; ++i)
+    {
+        DWORD pid = m_pHeader->m_pids[i];
+        if (pid == 0 || pid == self)
+            continue;
+
+        DoGetEventName(szName, sizeof(szName), pid);
+        HANDLE hEvent = OpenEventW(EVENT_MODIFY_STATE, FALSE, szName);
+        if (!hEvent)
+        {
+            m_pHeader->m_pids[i] = 0;   // the process is gone
+            continue;
+        }
+        SetEvent(hEvent);
+        CloseHandle(hEvent);
+    }
+}
+
+/*static*/ unsigned __stdcall MSharedSettings::WatcherProc(void *arg)
+{
+    MSharedSettings *pThis = (MSharedSettings *)arg;
+    HANDLE ahEvents[2] = { pThis->m_hQuit, pThis->m_hChanged };
+    while (WaitForMultipleObjects(2, ahEvents, FALSE, INFINITE) == WAIT_OBJECT_0 + 1)
+    {
+        PostMessage(pThis->m_hwndNotify, WM_COMMAND, pThis->m_nCommandID, 0);
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+// SharedSettings.hpp --- settings shared by SimpleBrowser processes
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef SHARED_SETTINGS_HPP_
+#define SHARED_SETTINGS_HPP_
+
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+#include <string>
+
+struct SETTINGS;
+
+// the size of the shared section
+#define SHARED_SETTINGS_SIZE    (1024 * 1024)
+
+// the number of the processes to be notified
+#define SHARED_MAX_INSTANCES    64
+
+// the head of the shared section.
+// The serialized settings (MFileSettings::Serialize) follow it.
+struct SHARED_SETTINGS_HEADER
+{
+    volatile LONG m_seq;    // seqlock: odd while writing
+    DWORD m_size;           // the size of the data
+    DWORD m_pids[SHARED_MAX_INSTANCES];     // the processes to be notified
+};
+
+// A named file mapping holds the latest settings of all the processes.
+// The writers are serialized by a named mutex, and the readers use the
+// seqlock without locking. Each process has its own change event that
+// the writers signal.
+// A writer merges the changes of the other processes under the mutex, so
+// nothing is lost between Read and Write. The SETTING_LOCAL entries (the
+// window place) stay in each process.
+class MSharedSettings
+{
+public:
+    MSharedSettings();
+    ~MSharedSettings();
+
+    // If another process has the section, the settings are read from it.
+    // Otherwise, the settings are published.
+    // nCommandID is posted to hwndNotify as WM_COMMAND on changes.
+    BOOL Open(SETTINGS& settings, HWND hwndNotify, UINT nCommandID);
+    void Close();
+
+    // returns TRUE if the settings were updated by another process
+    BOOL Read(SETTINGS& settings);
+    // *pbMerged is set to TRUE if the changes of another process were
+    // merged into the settings
+    BOOL Write(SETTINGS& settings, BOOL *pbMerged = NULL);
+
+protected:
+    HANDLE m_hMapping;
+    HANDLE m_hMutex;
+    HANDLE m_hChanged;
+    HANDLE m_hQuit;
+    HANDLE m_hThread;
+    SHARED_SETTINGS_HEADER *m_pHeader;
+    LONG m_seq;             // the last sequence number we saw
+    std::string m_base;     // the data of m_seq, the base of the merge
+    HWND m_hwndNotify;
+    UINT m_nCommandID;
+
+    BYTE *DoGetData() const;
+    void DoNotify();
+    static unsigned __stdcall WatcherProc(void *arg);
+};
+extern MSharedSettings g_shared_settings;
+
+#endif  // ndef SHARED_SETTINGS_HPP_
@@ -0,0 +1,174 @@
+// SuggestTrie.cpp --- the weighted completion trie
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "SuggestTrie.hpp"
+#include "UTF8Codec.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+// NOTE: This file doesn't depend on Win32 API.
+
+// the weights are saved in 32 bits
+#define SUGGEST_MAX_WEIGHT  0xFFFFFFFF
+
+static std::wstring DoFold(const std::wstring& str)
+{
+    std::wstring ret = str;
+    LowerText(ret);
+    return ret;
+}
+
+static unsigned long long DoEdgeKey(unsigned long iNode, wchar_t ch)
+{
+    return ((unsigned long long)iNode << 16) | (unsigned short)ch;
+}
+
+MSuggestTrie::MSuggestTrie()
+{
+    clear();
+}
+
+void MSuggestTrie::clear()
+{
+    m_terms.clear();
+    m_term2index.clear();
+    m_nodes.clear();
+    m_edges.clear();
+    m_nodes.push_back(NODE());   // root
+}
+
+size_t MSuggestTrie::size() const
+{
+    return m_terms.size();
+}
+
+void MSuggestTrie::DoUpdateTop(NODE& node, unsigned long iTerm)
+{
+    std::vector<unsigned long>& top = node.m_top;
+    size_t i = std::find(top.begin(), top.end(), iTerm) - top.begin();
+    if (i == top.size())
+    {
+        if (top.size() < SUGGEST_TOP_COUNT)
+            top.push_back(iTerm);
+        else if (m_terms[top.back()].m_weight < m_terms[iTerm].m_weight)
+            top.back() = iTerm;
+        else
+            return;
+        i = top.size() - 1;
+    }
+
+    // weights only grow, so the term can only move up from its place
+    for (; i > 0; --i)
+    {
+        if (m_terms[top[i - 1]].m_weight >= m_terms[top[i]].m_weight)
+            break;
+        std::swap(top[i - 1], top[i]);
+    }
+}
+
+void MSuggestTrie::Add(const std::wstring& text, SUGGEST_WEIGHT weight)
+{
+    if (text.empty() || text.size() > SUGGEST_MAX_TEXT || weight == 0)
+        return;
+    if (weight > SUGGEST_MAX_WEIGHT)
+        weight = SUGGEST_MAX_WEIGHT;
+
+    std::wstring folded = DoFold(text);
+
+    unsigned long iTerm;
+    auto it = m_term2index.find(folded);
+    if (it != m_term2index.end())
+    {
+        iTerm = it->second;
+        SUGGEST_WEIGHT& sum = m_terms[iTerm].m_weight;
+        sum = (sum < SUGGEST_MAX_WEIGHT - weight) ? sum + weight : SUGGEST_MAX_WEIGHT;
+    }
+    else
+    {
+        TERM term;
+        term.m_text = text;
+        term.m_weight = weight;
+        m_terms.push_back(term);
+        iTerm = (unsigned long)(m_terms.size() - 1);
+        m_term2index[folded] = iTerm;
+    }
+
+    unsigned long iNode = 0;
+    for (size_t i = 0; i < folded.size(); ++i)
+    {
+        unsigned long long key = DoEdgeKey(iNode, folded[i]);
+        auto edge = m_edges.find(key);
+        if (edge == m_edges.end())
+        {
+            m_nodes.push_back(NODE());
+            unsigned long iChild = (unsigned long)(m_nodes.size() - 1);
+            m_edges[key] = iChild;
+            iNode = iChild;
+        }
+        else
+        {
+            iNode = edge->second;
+        }
+        DoUpdateTop(m_nodes[iNode], iTerm);
+    }
+}
+
+size_t MSuggestTrie::Query(const std::wstring& prefix, std::vector<std::wstring>& results,
+                           size_t max_count) const
+{
+    results.clear();
+
+    std::wstring folded = DoFold(prefix);
+    if (folded.empty())
+        return 0;
+
+    unsigned long iNode = 0;
+    for (size_t i = 0; i < folded.size(); ++i)
+    {
+        auto edge = m_edges.find(DoEdgeKey(iNode, folded[i]));
+        if (edge == m_edges.end())
+            return 0;
+        iNode = edge->second;
+    }
+
+    const std::vector<unsigned long>& top = m_nodes[iNode].m_top;
+    for (size_t i = 0; i < top.size() && results.size() < max_count; ++i)
+    {
+        results.push_back(m_terms[top[i]].m_text);
+    }
+    return results.size();
+}
+
+void MSuggestTrie::Serialize(std::string& data) const
+{
+    data.clear();
+    char buf[32];
+    for (size_t i = 0; i < m_terms.size(); ++i)
+    {
+        const TERM& term = m_terms[i];
+        data.append(buf, std::sprintf(buf, "%lu\t", term.m_weight));
+        data += WideToUTF8(term.m_text);
+        data += '\n';
+    }
+}
+
+void MSuggestTrie::Parse(const std::string& data)
+{
+    size_t i = 0;
+    while (i < data.size())
+    {
+        size_t j = data.find('\n', i);
+        if (j == std::string::npos)
+            j = data.size();
+
+        size_t k = data.find('\t', i);
+        if (k < j)
+        {
+            SUGGEST_WEIGHT weight = std::strtoul(data.c_str() + i, NULL, 10);
+            Add(UTF8ToWide(&data[k + 1], j - k - 1), weight);
+        }
+        i = j + 1;
+    }
+}
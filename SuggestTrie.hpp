@@ -0,0 +1,63 @@
+// SuggestTrie.hpp --- the weighted completion trie
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef SUGGEST_TRIE_HPP_
+#define SUGGEST_TRIE_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// NOTE: This file doesn't depend on Win32 API.
+
+// the number of the completions cached in each trie node
+#define SUGGEST_TOP_COUNT   8
+
+// the maximum length of a search query to remember
+#define SUGGEST_MAX_TEXT    128
+
+typedef unsigned long SUGGEST_WEIGHT;
+
+// Each node caches the SUGGEST_TOP_COUNT heaviest terms below it, so a
+// query costs only the walk of the prefix. A new term goes after the
+// terms of the same weight. Not thread-safe; the caller locks it.
+class MSuggestTrie
+{
+public:
+    MSuggestTrie();
+
+    void clear();
+    size_t size() const;
+
+    // the case-insensitive duplicates add up their weights
+    void Add(const std::wstring& text, SUGGEST_WEIGHT weight = 1);
+    size_t Query(const std::wstring& prefix, std::vector<std::wstring>& results,
+                 size_t max_count = SUGGEST_TOP_COUNT) const;
+
+    // the UTF-8 text of Searches.txt, one "<weight>\t<query>" per line.
+    // Parse adds the terms of the data.
+    void Serialize(std::string& data) const;
+    void Parse(const std::string& data);
+
+protected:
+    struct TERM
+    {
+        std::wstring m_text;
+        SUGGEST_WEIGHT m_weight;
+    };
+    struct NODE
+    {
+        std::vector<unsigned long> m_top;   // indexes of m_terms, heaviest first
+    };
+
+    std::vector<TERM> m_terms;
+    std::unordered_map<std::wstring, unsigned long> m_term2index;
+    std::vector<NODE> m_nodes;
+    std::unordered_map<unsigned long long, unsigned long> m_edges;  // (node << 16 | ch) --> child
+
+    void DoUpdateTop(NODE& node, unsigned long iTerm);
+};
+
+#endif  // ndef SUGGEST_TRIE_HPP_
@@ -0,0 +1,120 @@
+// TaskGraph.cpp --- running the startup tasks in worker threads
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "TaskGraph.hpp"
+#include <process.h>
+#include <objbase.h>
+#include <cstdio>
+
+MTaskGraph::MTaskGraph() : m_iNext(0)
+{
+}
+
+MTaskGraph::~MTaskGraph()
+{
+    WaitAll();
+    for (size_t i = 0; i < m_tasks.size(); ++i)
+    {
+        CloseHandle(m_tasks[i].m_hDone);
+    }
+}
+
+INT MTaskGraph::Add(const char *name, TASK_PROC proc, void *arg, INT iAfter)
+{
+    TASK task;
+    task.m_name = name;
+    task.m_proc = proc;
+    task.m_arg = arg;
+    task.m_iAfter = (iAfter < INT(m_tasks.size())) ? iAfter : -1;
+    task.m_hDone = CreateEventW(NULL, TRUE, FALSE, NULL);
+    m_tasks.push_back(task);
+    return INT(m_tasks.size() - 1);
+}
+
+BOOL MTaskGraph::Run()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    size_t count = info.dwNumberOfProcessors;
+    if (count > TASK_MAX_THREADS)
+        count = TASK_MAX_THREADS;
+    if (count > m_tasks.size())
+        count = m_tasks.size();
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        HANDLE hThread = (HANDLE)_beginthreadex(NULL, 0, WorkerProc, this, 0, NULL);
+        if (hThread)
+            m_threads.push_back(hThread);
+    }
+
+    // no thread: run them in this thread
+    if (m_threads.empty())
+    {
+        while (DoRunNext())
+            ;
+    }
+
+    return !m_threads.empty();
+}
+
+// A worker takes the tasks in order, so the task it waits for was already
+// taken by another worker, and never waits for a task that isn't running.
+BOOL MTaskGraph::DoRunNext()
+{
+    LONG iTask = InterlockedIncrement(&m_iNext) - 1;
+    if (iTask >= LONG(m_tasks.size()))
+        return FALSE;
+
+    TASK& task = m_tasks[iTask];
+    if (task.m_iAfter >= 0)
+        WaitForSingleObject(m_tasks[task.m_iAfter].m_hDone, INFINITE);
+
+    LARGE_INTEGER freq, start, end;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+
+    (*task.m_proc)(task.m_arg);
+
+    QueryPerformanceCounter(&end);
+    printf("startup: task %s: %.2f ms (thread %lu)\n", task.m_name,
+           double(end.QuadPart - start.QuadPart) * 1000 / double(freq.QuadPart),
+           GetCurrentThreadId());
+
+    SetEvent(task.m_hDone);
+    return TRUE;
+}
+
+void MTaskGraph::Wait(INT iTask)
+{
+    if (0 <= iTask && iTask < INT(m_tasks.size()))
+        WaitForSingleObject(m_tasks[iTask].m_hDone, INFINITE);
+}
+
+void MTaskGraph::WaitAll()
+{
+    if (m_threads.empty())
+        return;
+
+    WaitForMultipleObjects(DWORD(m_threads.size()), &m_threads[0], TRUE, INFINITE);
+    for (size_t i = 0; i < m_threads.size(); ++i)
+    {
+        CloseHandle(m_threads[i]);
+    }
+    m_threads.clear();
+}
+
+/*static*/ unsigned __stdcall MTaskGraph::WorkerProc(void *arg)
+{
+    MTaskGraph *pThis = (MTaskGraph *)arg;
+
+    HRESULT hr = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+    while (pThis->DoRunNext())
+        ;
+    if (SUCCEEDED(hr))
+        CoUninitialize();
+
+    return 0;
+}
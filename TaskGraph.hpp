@@ -0,0 +1,55 @@
+// TaskGraph.hpp --- running the startup tasks in worker threads
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef TASK_GRAPH_HPP_
+#define TASK_GRAPH_HPP_
+
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+#include <vector>
+
+typedef void (*TASK_PROC)(void *arg);
+
+// the maximum number of the worker threads
+#define TASK_MAX_THREADS    4
+
+// A few threads run the tasks in the order of addition. A task can depend
+// on one task added before it. The workers have COM initialized.
+class MTaskGraph
+{
+public:
+    MTaskGraph();
+    ~MTaskGraph();
+
+    // returns the task index. iAfter is the task to wait for, or -1.
+    // name is shown in the startup profile and must be a literal.
+    INT Add(const char *name, TASK_PROC proc, void *arg, INT iAfter = -1);
+
+    // starts the workers. No more tasks can be added.
+    BOOL Run();
+
+    // waits for a task or all the tasks
+    void Wait(INT iTask);
+    void WaitAll();
+
+protected:
+    struct TASK
+    {
+        const char *m_name;
+        TASK_PROC m_proc;
+        void *m_arg;
+        INT m_iAfter;
+        HANDLE m_hDone;     // manual-reset
+    };
+
+    std::vector<TASK> m_tasks;
+    std::vector<HANDLE> m_threads;
+    LONG m_iNext;
+
+    BOOL DoRunNext();
+    static unsigned __stdcall WorkerProc(void *arg);
+};
+
+#endif  // ndef TASK_GRAPH_HPP_
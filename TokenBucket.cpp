@@ -0,0 +1,93 @@
+// TokenBucket.cpp --- the bandwidth limits of the downloads
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "TokenBucket.hpp"
+#include <chrono>
+
+// NOTE: This file doesn't depend on Win32 API.
+
+static TOKEN_TIME DoGetMicroseconds(void)
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+MTokenBucket::MTokenBucket(TOKEN_CLOCK clock) :
+    m_clock(clock ? clock : DoGetMicroseconds), m_rate(0), m_full(0)
+{
+}
+
+void MTokenBucket::SetRate(unsigned long bytes_per_sec)
+{
+    // a negative rate would be unlimited
+    if (bytes_per_sec > TOKEN_BUCKET_MAX_RATE)
+        bytes_per_sec = TOKEN_BUCKET_MAX_RATE;
+    m_rate = long(bytes_per_sec);
+}
+
+unsigned long MTokenBucket::GetRate() const
+{
+    return (unsigned long)m_rate;
+}
+
+unsigned long MTokenBucket::Consume(unsigned long cb)
+{
+    long rate = m_rate;
+    if (rate <= 0 || cb == 0)
+        return 0;
+
+    TOKEN_TIME now = m_clock();
+    TOKEN_TIME cost = TOKEN_TIME(cb) * 1000000 / rate;
+    TOKEN_TIME burst = TOKEN_TIME(TOKEN_BUCKET_BURST) * 1000;
+
+    TOKEN_TIME full = m_full, next;
+    do
+    {
+        // an idle bucket has no more than the burst
+        next = (full < now - burst) ? now - burst : full;
+        next += cost;
+    } while (!m_full.compare_exchange_weak(full, next));
+
+    if (next <= now)
+        return 0;
+    return (unsigned long)((next - now + 999) / 1000);
+}
+
+MDownloadPause::MDownloadPause(TOKEN_CLOCK clock) :
+    m_clock(clock ? clock : DoGetMicroseconds), m_depth(0), m_start(0)
+{
+}
+
+void MDownloadPause::Pause(bool bPause)
+{
+    if (bPause)
+    {
+        // the pause goes on while the pages are loading one after another.
+        // Keep the time when it started.
+        if (m_depth == 0)
+            m_start = m_clock();
+        ++m_depth;
+    }
+    else if (m_depth > 0)
+    {
+        --m_depth;
+    }
+}
+
+bool MDownloadPause::IsPaused() const
+{
+    return m_depth > 0;
+}
+
+unsigned long MDownloadPause::GetWaitTime() const
+{
+    if (m_depth <= 0)
+        return 0;
+
+    // DOWNLOAD_PAUSE_MAX is for the whole pause, not for each call
+    TOKEN_TIME left = TOKEN_TIME(DOWNLOAD_PAUSE_MAX) * 1000 - (m_clock() - m_start);
+    if (left <= 0)
+        return 0;
+    return (unsigned long)((left + 999) / 1000);
+}
@@ -0,0 +1,69 @@
+// TokenBucket.hpp --- the bandwidth limits of the downloads
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef TOKEN_BUCKET_HPP_
+#define TOKEN_BUCKET_HPP_
+
+#include <atomic>
+#include <cstddef>
+
+// NOTE: This file doesn't depend on Win32 API.
+
+// the burst of a bucket, in milliseconds of its rate
+#define TOKEN_BUCKET_BURST      250
+
+// the maximum rate. The rate is kept in a signed long (MAXLONG).
+#define TOKEN_BUCKET_MAX_RATE   0x7FFFFFFF
+
+// the longest pause while a page is loading, in milliseconds.
+// The downloads go on after it even if the page is still loading.
+#define DOWNLOAD_PAUSE_MAX      (30 * 1000)
+
+typedef long long TOKEN_TIME;   // in microseconds
+
+// returns the monotonic time. NULL is std::chrono::steady_clock.
+typedef TOKEN_TIME (*TOKEN_CLOCK)(void);
+
+// A token bucket without locking. It keeps the time when the bucket will
+// be full again, and a consumer moves it forward by one compare-exchange.
+// The tokens can be borrowed; the consumer waits for the debt.
+class MTokenBucket
+{
+public:
+    MTokenBucket(TOKEN_CLOCK clock = NULL);
+
+    // bytes per second. Zero is unlimited. Clipped to TOKEN_BUCKET_MAX_RATE.
+    void SetRate(unsigned long bytes_per_sec);
+    unsigned long GetRate() const;
+
+    // takes cb bytes and returns the milliseconds to wait
+    unsigned long Consume(unsigned long cb);
+
+protected:
+    TOKEN_CLOCK m_clock;
+    std::atomic<long> m_rate;
+    std::atomic<TOKEN_TIME> m_full;
+};
+
+// The downloads pause while the pages are loading. Pause(true) and
+// Pause(false) nest, and the whole pause lasts DOWNLOAD_PAUSE_MAX at most.
+// Pause is called by one thread, and GetWaitTime by any thread.
+class MDownloadPause
+{
+public:
+    MDownloadPause(TOKEN_CLOCK clock = NULL);
+
+    void Pause(bool bPause);
+    bool IsPaused() const;
+
+    // the milliseconds left of the pause. Zero if not paused.
+    unsigned long GetWaitTime() const;
+
+protected:
+    TOKEN_CLOCK m_clock;
+    std::atomic<long> m_depth;
+    std::atomic<TOKEN_TIME> m_start;
+};
+
+#endif  // ndef TOKEN_BUCKET_HPP_
@@ -1,13 +1,13 @@
-// URLListDlg.hpp --- URL list dialog
-// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
-// This file is public domain software.
-
-#ifndef URL_LIST_DLG_HPP_
-#define URL_LIST_DLG_HPP_
-#ifndef _INC_WINDOWS
-    #include <windows.h>
-#endif
-
-void ShowURLListDlg(HINSTANCE hInst, HWND hwnd);
-
-#endif  // ndef URL_LIST_DLG_HPP_
+// URLListDlg.hpp --- URL list dialog
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef URL_LIST_DLG_HPP_
+#define URL_LIST_DLG_HPP_
+#ifndef _INC_WINDOWS
+    #include <windows.h>
+#endif
+
+void ShowURLListDlg(HINSTANCE hInst, HWND hwnd);
+
+#endif  // ndef URL_LIST_DLG_HPP_
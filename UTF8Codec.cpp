@@ -0,0 +1,191 @@
+// UTF8Codec.cpp --- the conversion between UTF-8 and UTF-16
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "UTF8Codec.hpp"
+#include <cstring>
+
+size_t DecodeUTF8(const char *pch, size_t cch, wchar_t *pszOut)
+{
+    const unsigned char *pb = (const unsigned char *)pch, *end = pb + cch;
+    wchar_t *out = pszOut;
+    while (pb < end)
+    {
+        // ASCII fast path: 8 bytes at once
+        while (end - pb >= 8)
+        {
+            unsigned int lo, hi;
+            memcpy(&lo, pb, 4);
+            memcpy(&hi, pb + 4, 4);
+            if ((lo | hi) & 0x80808080)
+                break;
+            for (int i = 0; i < 8; ++i)
+                out[i] = pb[i];
+            out += 8;
+            pb += 8;
+        }
+        if (pb >= end)
+            break;
+
+        unsigned int ch = *pb;
+        if (ch < 0x80)
+        {
+            *out++ = wchar_t(ch);
+            ++pb;
+            continue;
+        }
+
+        // the length of the sequence and the minimum value
+        size_t len;
+        unsigned int min;
+        if ((ch & 0xE0) == 0xC0)
+        {
+            len = 2;
+            min = 0x80;
+            ch &= 0x1F;
+        }
+        else if ((ch & 0xF0) == 0xE0)
+        {
+            len = 3;
+            min = 0x800;
+            ch &= 0x0F;
+        }
+        else if ((ch & 0xF8) == 0xF0)
+        {
+            len = 4;
+            min = 0x10000;
+            ch &= 0x07;
+        }
+        else
+        {
+            *out++ = 0xFFFD;
+            ++pb;
+            continue;
+        }
+
+        size_t i;
+        for (i = 1; i < len && pb + i < end && (pb[i] & 0xC0) == 0x80; ++i)
+        {
+            ch = (ch << 6) | (pb[i] & 0x3F);
+        }
+        if (i < len || ch < min || ch > 0x10FFFF || (ch >= 0xD800 && ch <= 0xDFFF))
+        {
+            *out++ = 0xFFFD;
+            pb += i;
+            continue;
+        }
+        pb += len;
+
+        if (ch >= 0x10000)
+        {
+            ch -= 0x10000;
+            *out++ = wchar_t(0xD800 + (ch >> 10));
+            *out++ = wchar_t(0xDC00 + (ch & 0x3FF));
+        }
+        else
+        {
+            *out++ = wchar_t(ch);
+        }
+    }
+    return out - pszOut;
+}
+
+void EncodeUTF8(const wchar_t *pch, size_t cch, std::string& out)
+{
+    out.clear();
+    out.reserve(cch);
+    for (size_t i = 0; i < cch; ++i)
+    {
+        unsigned int ch = (unsigned int)pch[i] & 0xFFFF;
+        if (ch < 0x80)
+        {
+            out += char(ch);
+            continue;
+        }
+
+        if (0xD800 <= ch && ch <= 0xDBFF && i + 1 < cch &&
+            0xDC00 <= ((unsigned int)pch[i + 1] & 0xFFFF) &&
+            ((unsigned int)pch[i + 1] & 0xFFFF) <= 0xDFFF)
+        {
+            unsigned int low = (unsigned int)pch[++i] & 0xFFFF;
+            ch = 0x10000 + ((ch - 0xD800) << 10) + (low - 0xDC00);
+        }
+        else if (0xD800 <= ch && ch <= 0xDFFF)
+        {
+            ch = 0xFFFD;
+        }
+
+        if (ch < 0x800)
+        {
+            out += char(0xC0 | (ch >> 6));
+        }
+        else if (ch < 0x10000)
+        {
+            out += char(0xE0 | (ch >> 12));
+            out += char(0x80 | ((ch >> 6) & 0x3F));
+        }
+        else
+        {
+            out += char(0xF0 | (ch >> 18));
+            out += char(0x80 | ((ch >> 12) & 0x3F));
+            out += char(0x80 | ((ch >> 6) & 0x3F));
+        }
+        out += char(0x80 | (ch & 0x3F));
+    }
+}
+
+std::wstring UTF8ToWide(const char *pch, size_t cch)
+{
+    std::wstring ret;
+    if (cch == 0)
+        return ret;
+    ret.resize(cch);
+    ret.resize(DecodeUTF8(pch, cch, &ret[0]));
+    return ret;
+}
+
+std::string WideToUTF8(const std::wstring& str)
+{
+    std::string ret;
+    EncodeUTF8(str.c_str(), str.size(), ret);
+    return ret;
+}
+
+static inline wchar_t DoLowerChar(wchar_t ch)
+{
+    unsigned int u = (unsigned int)ch;
+    if (u < 0x80)
+    {
+        if ('A' <= u && u <= 'Z')
+            return wchar_t(u + 0x20);
+        return ch;
+    }
+    if ((0xC0 <= u && u <= 0xDE && u != 0xD7) ||    // Latin-1
+        (0x391 <= u && u <= 0x3AB && u != 0x3A2) || // Greek
+        (0x410 <= u && u <= 0x42F) ||               // Cyrillic
+        (0xFF21 <= u && u <= 0xFF3A))               // fullwidth Latin
+    {
+        return wchar_t(u + 0x20);
+    }
+    if (0x400 <= u && u <= 0x40F)                   // Cyrillic
+        return wchar_t(u + 0x50);
+    if (0x100 <= u && u <= 0x17F)                   // Latin Extended-A
+    {
+        if ((0x139 <= u && u <= 0x148) || (0x179 <= u && u <= 0x17E))
+            return (u & 1) ? wchar_t(u + 1) : ch;
+        if (u == 0x178)
+            return wchar_t(0xFF);
+        if (u == 0x130 || u == 0x138 || u == 0x149 || u == 0x17F)
+            return ch;
+        return (u & 1) ? ch : wchar_t(u + 1);
+    }
+    return ch;
+}
+
+void LowerText(std::wstring& str)
+{
+    for (size_t i = 0; i < str.size(); ++i)
+    {
+        str[i] = DoLowerChar(str[i]);
+    }
+}
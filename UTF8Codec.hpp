@@ -0,0 +1,29 @@
+// UTF8Codec.hpp --- the conversion between UTF-8 and UTF-16
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef UTF8_CODEC_HPP_
+#define UTF8_CODEC_HPP_
+
+#include <cstddef>
+#include <string>
+
+// NOTE: This file doesn't depend on Win32 API.
+// The wide strings are UTF-16 code units even if wchar_t is 32-bit.
+
+// UTF-8 --> UTF-16 code units. pszOut needs cch units at most.
+// The invalid sequences become U+FFFD. Returns the number of the units.
+size_t DecodeUTF8(const char *pch, size_t cch, wchar_t *pszOut);
+
+// UTF-16 code units --> UTF-8. A lone surrogate becomes U+FFFD.
+void EncodeUTF8(const wchar_t *pch, size_t cch, std::string& out);
+
+std::wstring UTF8ToWide(const char *pch, size_t cch);
+std::string WideToUTF8(const std::wstring& str);
+
+// Lowercases the letters of ASCII, Latin-1, Latin Extended-A, Greek,
+// Cyrillic and the fullwidth Latin in place, like CharLowerBuffW does for
+// the names and the URLs.
+void LowerText(std::wstring& str);
+
+#endif  // ndef UTF8_CODEC_HPP_
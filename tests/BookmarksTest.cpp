@@ -0,0 +1,206 @@
+// BookmarksTest.cpp --- the test of BookmarkList
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "BookmarkList.hpp"
+#include "Test.hpp"
+#include <algorithm>
+
+static bool DoIsNormalized(const wchar_t *url, const wchar_t *expected)
+{
+    return MBookmarkList::NormalizeURL(url) == expected;
+}
+
+static void DoTestNormalizeURL()
+{
+    TEST_CHECK(DoIsNormalized(L"  http://Example.COM/Path?Q#frag \n",
+                              L"http://example.com/Path?Q"));
+    TEST_CHECK(DoIsNormalized(L"HTTP://example.com:80/a", L"http://example.com/a"));
+    TEST_CHECK(DoIsNormalized(L"https://example.com:443", L"https://example.com"));
+    TEST_CHECK(DoIsNormalized(L"http://example.com:443/", L"http://example.com:443"));
+    TEST_CHECK(DoIsNormalized(L"http://example.com/", L"http://example.com"));
+    TEST_CHECK(DoIsNormalized(L"http://example.com/a/", L"http://example.com/a/"));
+    TEST_CHECK(DoIsNormalized(L"Example.com?X", L"example.com?X"));
+    TEST_CHECK(DoIsNormalized(L" \t ", L""));
+
+    // the fullwidth and Latin-1 letters of the host
+    TEST_CHECK(DoIsNormalized(L"http://\xFF21\x00C9.jp/\x00C9", L"http://\xFF41\x00E9.jp/\x00C9"));
+}
+
+static void DoTestFind()
+{
+    MBookmarkList list;
+    BOOKMARK_ID folder = list.AddFolder(BOOKMARK_ROOT, L"Folder");
+    BOOKMARK_ID a = list.AddBookmark(folder, L"A", L"http://a.example/");
+    BOOKMARK_ID b = list.AddBookmark(BOOKMARK_ROOT, L"B", L"http://b.example/x");
+    BOOKMARK_ID a2 = list.AddBookmark(BOOKMARK_ROOT, L"A2", L"HTTP://A.EXAMPLE:80");
+    TEST_CHECK(list.size() == 4);
+
+    // the last one of the duplicates
+    TEST_CHECK(list.Find(L"http://a.example") == a2);
+    TEST_CHECK(list.Find(L"http://b.example/x#top") == b);
+    TEST_CHECK(!list.IsBookmarked(L"http://c.example"));
+    TEST_CHECK(list.Find(L"Folder") == BOOKMARK_ROOT);
+
+    // the index is re-pointed to the other duplicate
+    TEST_CHECK(list.Remove(a2));
+    TEST_CHECK(!list.Remove(a2));
+    TEST_CHECK(list.Find(L"http://a.example") == a);
+
+    // removing a folder removes its items
+    TEST_CHECK(list.Remove(folder));
+    TEST_CHECK(list[a].m_deleted);
+    TEST_CHECK(!list.IsBookmarked(L"http://a.example"));
+    TEST_CHECK(list.IsBookmarked(L"http://b.example/x"));
+    TEST_CHECK(!list.Remove(12345));
+}
+
+static void DoTestSearch()
+{
+    MBookmarkList list;
+    BOOKMARK_ID news = list.AddBookmark(BOOKMARK_ROOT, L"News Today", L"https://www.news.example/");
+    BOOKMARK_ID wiki = list.AddBookmark(BOOKMARK_ROOT, L"Wiki", L"http://newspaper.example/");
+    BOOKMARK_ID folder = list.AddFolder(BOOKMARK_ROOT, L"News folder");
+    BOOKMARK_ID gone = list.AddBookmark(BOOKMARK_ROOT, L"News gone", L"http://gone.example/");
+    list.Remove(gone);
+
+    // the title and the URL without the scheme and "www."
+    std::vector<BOOKMARK_ID> results;
+    TEST_CHECK(list.Search(L"NEWS", results, 8) == 2);
+    TEST_CHECK(std::find(results.begin(), results.end(), news) != results.end());
+    TEST_CHECK(std::find(results.begin(), results.end(), wiki) != results.end());
+    TEST_CHECK(std::find(results.begin(), results.end(), folder) == results.end());
+
+    TEST_CHECK(list.Search(L"newsp", results, 8) == 1);
+    TEST_CHECK(results[0] == wiki);
+    TEST_CHECK(list.Search(L"www", results, 8) == 0);
+    TEST_CHECK(list.Search(L"", results, 8) == 0);
+    TEST_CHECK(list.Search(L"n", results, 1) == 1);
+
+    // the index is sorted again after a change
+    BOOKMARK_ID zebra = list.AddBookmark(BOOKMARK_ROOT, L"Zebra", L"http://z.example/");
+    TEST_CHECK(list.Search(L"zeb", results, 8) == 1);
+    TEST_CHECK(results[0] == zebra);
+}
+
+static void DoTestSerialize()
+{
+    MBookmarkList list;
+    BOOKMARK_ID gone = list.AddBookmark(BOOKMARK_ROOT, L"Gone", L"http://gone.example/");
+    BOOKMARK_ID folder = list.AddFolder(BOOKMARK_ROOT, L"\x65E5\x672C");
+    list.AddBookmark(folder, L"Emoji \xD83D\xDE00", L"http://a.example/", L"x,y");
+    list.AddBookmark(BOOKMARK_ROOT, std::wstring(300, L'T'), L"http://b.example/");
+    list.Remove(gone);
+
+    std::string data;
+    list.Serialize(data);
+    TEST_CHECK(data.compare(0, 4, "SBBM") == 0);
+
+    // the deleted item is dropped and the parents are renumbered
+    MBookmarkList loaded;
+    TEST_CHECK(loaded.Parse(data));
+    TEST_CHECK(loaded.size() == 3);
+    TEST_CHECK(loaded[0].m_is_folder);
+    TEST_CHECK(loaded[0].m_parent == BOOKMARK_ROOT);
+    TEST_CHECK(loaded[0].m_title == L"\x65E5\x672C");
+    TEST_CHECK(!loaded[1].m_is_folder);
+    TEST_CHECK(loaded[1].m_parent == 0);
+    TEST_CHECK(loaded[1].m_title == L"Emoji \xD83D\xDE00");
+    TEST_CHECK(loaded[1].m_tags == L"x,y");
+    TEST_CHECK(loaded[2].m_title.size() == 300);
+    TEST_CHECK(loaded.Find(L"http://a.example") == 1);
+
+    std::string data2;
+    loaded.Serialize(data2);
+    TEST_CHECK(data2 == data);
+
+    // every truncation fails
+    for (size_t cb = 0; cb < data.size(); ++cb)
+    {
+        TEST_CHECK(!loaded.Parse(data.substr(0, cb)));
+    }
+
+    // a bad magic or version
+    std::string bad = data;
+    bad[0] = 'X';
+    TEST_CHECK(!loaded.Parse(bad));
+    bad = data;
+    bad[4] = 2;
+    TEST_CHECK(!loaded.Parse(bad));
+    TEST_CHECK(loaded.size() == 0);
+
+    // a string longer than the rest
+    bad = data.substr(0, 6);
+    bad += std::string("\x00\x00\x7F", 3);
+    TEST_CHECK(!loaded.Parse(bad));
+
+    // an empty list
+    MBookmarkList empty;
+    empty.Serialize(data);
+    TEST_CHECK(data.size() == 6);
+    TEST_CHECK(loaded.Parse(data));
+    TEST_CHECK(loaded.size() == 0);
+}
+
+// imports the text in chunks of cb bytes
+static void DoImport(MBookmarkList& list, const std::string& text, size_t cb)
+{
+    MBookmarkImporter importer(list);
+    for (size_t i = 0; i < text.size(); i += cb)
+    {
+        importer.Feed(text.c_str() + i, std::min(cb, text.size() - i));
+    }
+}
+
+static void DoTestImport()
+{
+    static const char s_szHTML[] =
+        "\xEF\xBB\xBF<!DOCTYPE NETSCAPE-Bookmark-file-1>\r\n"
+        "<DL><p>\r\n"
+        "  <DT><H3 ADD_DATE=\"1\">Tom &amp; Jerry</H3>\r\n"
+        "  <DL><p>\r\n"
+        "    <DT><A HREF=\"http://a.example/?x=1&amp;y=2\" TAGS='t1,t2'>A &lt;b&gt; &#x41;&#66;</A>\r\n"
+        "    <DT><A HREF=\"http://b.example/\" title=\"a > b\">&#x1F600; &quot;q&quot; &unknown; & x</A>\r\n"
+        "  </DL><p>\r\n"
+        "  <DT><A href=http://c.example/ >C</A>\r\n"
+        "  <DT><A HREF=\"http://A.example/?x=1&y=2\">duplicate</A>\r\n"
+        "</DL>\r\n";
+    std::string text = s_szHTML;
+
+    // the same result whatever the chunks are
+    for (size_t cb = 1; cb <= text.size(); cb = (cb < 8) ? cb + 1 : cb * 2)
+    {
+        MBookmarkList list;
+        DoImport(list, text, cb);
+        TEST_CHECK(list.size() == 4);
+        if (list.size() != 4)
+            continue;
+
+        TEST_CHECK(list[0].m_is_folder);
+        TEST_CHECK(list[0].m_title == L"Tom & Jerry");
+        TEST_CHECK(list[1].m_parent == 0);
+        TEST_CHECK(list[1].m_url == L"http://a.example/?x=1&y=2");
+        TEST_CHECK(list[1].m_title == L"A <b> AB");
+        TEST_CHECK(list[1].m_tags == L"t1,t2");
+        TEST_CHECK(list[2].m_parent == 0);
+        TEST_CHECK(list[2].m_title == L"\xD83D\xDE00 \"q\" &unknown; & x");
+        TEST_CHECK(list[3].m_parent == BOOKMARK_ROOT);
+        TEST_CHECK(list[3].m_url == L"http://c.example/");
+    }
+
+    // the URLs already bookmarked are skipped
+    MBookmarkList list;
+    list.AddBookmark(BOOKMARK_ROOT, L"C", L"http://c.example");
+    DoImport(list, text, 4096);
+    TEST_CHECK(list.size() == 4);
+}
+
+int main(void)
+{
+    DoTestNormalizeURL();
+    DoTestFind();
+    DoTestSearch();
+    DoTestSerialize();
+    DoTestImport();
+    return TEST_RESULT();
+}
@@ -0,0 +1,157 @@
+// ConfigTableTest.cpp --- the test of ConfigTable
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "ConfigTable.hpp"
+#include "Test.hpp"
+#include <cstring>
+#include <vector>
+
+// a copy of the blob aligned to 4 bytes, with room after it
+struct TABLE_BUFFER
+{
+    std::vector<uint32_t> m_words;
+    size_t m_cb;
+
+    TABLE_BUFFER(const std::string& blob) : m_words(blob.size() / 4 + 2), m_cb(blob.size())
+    {
+        std::memcpy(&m_words[0], blob.data(), blob.size());
+    }
+
+    unsigned char *data()
+    {
+        return (unsigned char *)&m_words[0];
+    }
+    uint32_t& word(size_t i)
+    {
+        return m_words[i];
+    }
+    bool Attach(MConfigTable& table)
+    {
+        return table.Attach(data(), m_cb);
+    }
+};
+
+static bool DoIsField(const MConfigTable& table, size_t iRow, size_t iField, const char *ascii)
+{
+    const CONFIG_CHAR *pch = table.GetField(iRow, iField);
+    size_t i;
+    for (i = 0; ascii[i]; ++i)
+    {
+        if (pch[i] != CONFIG_CHAR((unsigned char)ascii[i]))
+            return false;
+    }
+    return pch[i] == 0;
+}
+
+static void DoTestRoundTrip()
+{
+    std::string text = "\xEF\xBB\xBF" "a\tb\n"
+                       "; comment\n"
+                       "skipped\n"
+                       "  c  \t d \t e\r\n"
+                       "\xE6\x97\xA5\t\xF0\x9F\x98\x80\n";
+    std::string blob;
+    MConfigTable::Compile(text.data(), text.size(), blob);
+    TEST_CHECK(blob.size() % 4 == 0);
+
+    TABLE_BUFFER buffer(blob);
+    MConfigTable table;
+    TEST_CHECK(buffer.Attach(table));
+    TEST_CHECK(table.GetRowCount() == 3);
+    TEST_CHECK(table.GetFieldCount(0) == 2);
+    TEST_CHECK(DoIsField(table, 0, 0, "a"));
+    TEST_CHECK(DoIsField(table, 0, 1, "b"));
+    TEST_CHECK(table.GetFieldCount(1) == 3);
+    TEST_CHECK(DoIsField(table, 1, 0, "c"));
+    TEST_CHECK(DoIsField(table, 1, 2, "e"));
+
+    // UTF-16, a surrogate pair for U+1F600
+    const CONFIG_CHAR *pch = table.GetField(2, 0);
+    TEST_CHECK(pch[0] == 0x65E5 && pch[1] == 0);
+    pch = table.GetField(2, 1);
+    TEST_CHECK(pch[0] == 0xD83D && pch[1] == 0xDE00 && pch[2] == 0);
+
+    // out of range
+    TEST_CHECK(table.GetFieldCount(3) == 0);
+    TEST_CHECK(DoIsField(table, 0, 2, ""));
+    TEST_CHECK(DoIsField(table, 5, 0, ""));
+
+    // no rows
+    MConfigTable::Compile("", 0, blob);
+    TABLE_BUFFER empty(blob);
+    TEST_CHECK(empty.Attach(table));
+    TEST_CHECK(table.GetRowCount() == 0);
+}
+
+static void DoTestBadBlob()
+{
+    std::string text = "a\tb\nc\td\te\n";
+    std::string blob;
+    MConfigTable::Compile(text.data(), text.size(), blob);
+
+    // header (2) + rows (3) + fields (5) words, then the strings
+    MConfigTable table;
+    TABLE_BUFFER good(blob);
+    TEST_CHECK(good.Attach(table));
+    TEST_CHECK(good.word(0) == 2 && good.word(1) == 5);
+
+    // a failure detaches the table
+    TEST_CHECK(!table.Attach(NULL, blob.size()));
+    TEST_CHECK(table.GetRowCount() == 0);
+
+    // the misaligned size and pointer
+    TABLE_BUFFER buffer(blob);
+    TEST_CHECK(!table.Attach(buffer.data(), blob.size() - 2));
+    TEST_CHECK(!table.Attach(buffer.data(), blob.size() + 2));
+    TEST_CHECK(!table.Attach(buffer.data() + 2, blob.size() - 4));
+    TEST_CHECK(!table.Attach(buffer.data(), 4));
+
+    // the counts beyond the blob
+    buffer = TABLE_BUFFER(blob);
+    buffer.word(0) = 0xFFFFFFFF;
+    TEST_CHECK(!buffer.Attach(table));
+    buffer = TABLE_BUFFER(blob);
+    buffer.word(1) = uint32_t(blob.size());
+    TEST_CHECK(!buffer.Attach(table));
+
+    // the rows out of order or not ending at the field count
+    buffer = TABLE_BUFFER(blob);
+    buffer.word(2) = 1;
+    TEST_CHECK(!buffer.Attach(table));
+    buffer = TABLE_BUFFER(blob);
+    buffer.word(3) = 6;
+    TEST_CHECK(!buffer.Attach(table));
+    buffer = TABLE_BUFFER(blob);
+    buffer.word(4) = 4;
+    TEST_CHECK(!buffer.Attach(table));
+
+    // the field offsets into the index, beyond the end, or odd
+    buffer = TABLE_BUFFER(blob);
+    buffer.word(5) = 8;
+    TEST_CHECK(!buffer.Attach(table));
+    buffer = TABLE_BUFFER(blob);
+    buffer.word(9) = uint32_t(blob.size());
+    TEST_CHECK(!buffer.Attach(table));
+    buffer = TABLE_BUFFER(blob);
+    buffer.word(6) += 1;
+    TEST_CHECK(!buffer.Attach(table));
+
+    // the missing terminator
+    buffer = TABLE_BUFFER(blob);
+    buffer.data()[blob.size() - 2] = 'x';
+    TEST_CHECK(!buffer.Attach(table));
+
+    // the last field ends at the terminator
+    buffer = TABLE_BUFFER(blob);
+    buffer.word(9) = uint32_t(blob.size() - sizeof(CONFIG_CHAR));
+    TEST_CHECK(buffer.Attach(table));
+    TEST_CHECK(DoIsField(table, 1, 2, ""));
+}
+
+int main(void)
+{
+    DoTestRoundTrip();
+    DoTestBadBlob();
+    return TEST_RESULT();
+}
@@ -0,0 +1,166 @@
+// ConfigTokenizerTest.cpp --- the test of ConfigTokenizer
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "ConfigTokenizer.hpp"
+#include "Test.hpp"
+#include <string>
+#include <vector>
+
+typedef std::vector<std::string> row_type;
+
+// the rows of the text
+static std::vector<row_type> DoTokenize(const std::string& text)
+{
+    std::vector<row_type> rows;
+    std::vector<CONFIG_FIELD> fields;
+    MConfigTokenizer tokenizer(text.data(), text.size());
+    while (tokenizer.NextRow(fields))
+    {
+        row_type row;
+        for (size_t i = 0; i < fields.size(); ++i)
+        {
+            row.push_back(std::string(fields[i].m_ptr, fields[i].m_len));
+        }
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+static row_type DoRow(const char *a, const char *b, const char *c = NULL)
+{
+    row_type row;
+    row.push_back(a);
+    row.push_back(b);
+    if (c)
+        row.push_back(c);
+    return row;
+}
+
+// the UTF-16 code units of the UTF-8 text
+static std::vector<unsigned int> DoDecode(const std::string& text)
+{
+    std::vector<wchar_t> buf(text.size() + 1);
+    size_t cch = DecodeUTF8(text.data(), text.size(), &buf[0]);
+    return std::vector<unsigned int>(buf.begin(), buf.begin() + cch);
+}
+
+static std::vector<unsigned int> DoUnits(unsigned int a, unsigned int b = 0,
+                                         unsigned int c = 0)
+{
+    std::vector<unsigned int> units(1, a);
+    if (b)
+        units.push_back(b);
+    if (c)
+        units.push_back(c);
+    return units;
+}
+
+static void DoTestRows()
+{
+    std::vector<row_type> rows = DoTokenize("a\tb\nc\td\te\n");
+    TEST_CHECK(rows.size() == 2);
+    TEST_CHECK(rows[0] == DoRow("a", "b"));
+    TEST_CHECK(rows[1] == DoRow("c", "d", "e"));
+
+    // no newline at the end
+    rows = DoTokenize("a\t\tc");
+    TEST_CHECK(rows.size() == 1);
+    TEST_CHECK(rows[0] == DoRow("a", "", "c"));
+}
+
+static void DoTestBOM()
+{
+    std::vector<row_type> rows = DoTokenize("\xEF\xBB\xBF" "a\tb\r\n");
+    TEST_CHECK(rows.size() == 1);
+    TEST_CHECK(rows[0] == DoRow("a", "b"));
+
+    // only at the top
+    rows = DoTokenize("x\ty\n\xEF\xBB\xBF" "a\tb\n");
+    TEST_CHECK(rows.size() == 2);
+    TEST_CHECK(rows[1] == DoRow("\xEF\xBB\xBF" "a", "b"));
+}
+
+static void DoTestComment()
+{
+    std::vector<row_type> rows = DoTokenize("; comment\ta\n"
+                                            "a\tb ; c\td\n"
+                                            "e ;\tf\n"
+                                            "g\th;\n");
+    TEST_CHECK(rows.size() == 2);
+    TEST_CHECK(rows[0] == DoRow("a", "b"));
+    TEST_CHECK(rows[1] == DoRow("g", "h"));
+}
+
+static void DoTestTrim()
+{
+    std::vector<row_type> rows = DoTokenize("  a \t  b  \r\n\n  \nc\t \t\td\n");
+    TEST_CHECK(rows.size() == 2);
+    TEST_CHECK(rows[0] == DoRow("a", "b"));
+    TEST_CHECK(rows[1].size() == 4 && rows[1][1].empty() && rows[1][3] == "d");
+
+    // the tabs around the line are trimmed with it
+    TEST_CHECK(DoTokenize("\tsingle\t\n").empty());
+
+    // less than two fields
+    TEST_CHECK(DoTokenize("single\n\n \r\n").empty());
+    TEST_CHECK(DoTokenize("").empty());
+}
+
+static void DoTestLongLine()
+{
+    // longer than the old 256-byte line buffer
+    std::string text(100000, 'x');
+    text += "\ty\nz\tw\n";
+    std::vector<row_type> rows = DoTokenize(text);
+    TEST_CHECK(rows.size() == 2);
+    TEST_CHECK(rows[0].size() == 2 && rows[0][0].size() == 100000 && rows[0][1] == "y");
+    TEST_CHECK(rows[1] == DoRow("z", "w"));
+}
+
+static void DoTestDecode()
+{
+    TEST_CHECK(DoDecode("").empty());
+    std::string ascii = "ABCDEFGHIJ";
+    TEST_CHECK(DoDecode(ascii) == std::vector<unsigned int>(ascii.begin(), ascii.end()));
+    TEST_CHECK(DoDecode("\xC3\xA9") == DoUnits(0xE9));
+    TEST_CHECK(DoDecode("\xE3\x81\x82") == DoUnits(0x3042));
+    TEST_CHECK(DoDecode("\xF0\x9F\x98\x80") == DoUnits(0xD83D, 0xDE00));
+
+    // the ASCII fast path stops at a non-ASCII byte
+    std::vector<unsigned int> units = DoDecode("abcdefg\xE3\x81\x82hijklmnop");
+    TEST_CHECK(units.size() == 17 && units[7] == 0x3042 && units[16] == 'p');
+}
+
+static void DoTestInvalidUTF8()
+{
+    // a lone continuation byte and the bytes never used
+    TEST_CHECK(DoDecode("\x80") == DoUnits(0xFFFD));
+    TEST_CHECK(DoDecode("\xFF" "a") == DoUnits(0xFFFD, 'a'));
+
+    // truncated at the end and in the middle
+    TEST_CHECK(DoDecode("\xE3\x81") == DoUnits(0xFFFD));
+    TEST_CHECK(DoDecode("\xE3\x81" "a") == DoUnits(0xFFFD, 'a'));
+
+    // overlong, a surrogate and beyond U+10FFFF
+    TEST_CHECK(DoDecode("\xC0\x80") == DoUnits(0xFFFD));
+    TEST_CHECK(DoDecode("\xE0\x80\x80") == DoUnits(0xFFFD));
+    TEST_CHECK(DoDecode("\xED\xA0\x80") == DoUnits(0xFFFD));
+    TEST_CHECK(DoDecode("\xF4\x90\x80\x80") == DoUnits(0xFFFD));
+
+    // the output is not longer than the input
+    std::string text = "\xE3\x81\x82\xF0\x9F\x98\x80\x80\xC0\x80" "abc";
+    TEST_CHECK(DoDecode(text).size() <= text.size());
+}
+
+int main(void)
+{
+    DoTestRows();
+    DoTestBOM();
+    DoTestComment();
+    DoTestTrim();
+    DoTestLongLine();
+    DoTestDecode();
+    DoTestInvalidUTF8();
+    return TEST_RESULT();
+}
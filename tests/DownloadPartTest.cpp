@@ -0,0 +1,215 @@
+// DownloadPartTest.cpp --- the test of DownloadPart
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "DownloadPart.hpp"
+#include "Test.hpp"
+
+static DOWNLOAD_SEGMENT DoSegment(SEGMENT_POS begin, SEGMENT_POS end)
+{
+    DOWNLOAD_SEGMENT segment;
+    segment.m_begin = begin;
+    segment.m_end = end;
+    segment.m_active = true;
+    segment.m_writing = 0;
+    return segment;
+}
+
+static DOWNLOAD_PART DoSamplePart()
+{
+    DOWNLOAD_PART part;
+    part.m_url = "http://example.com/file.zip";
+    part.m_etag = "\"abc\"";
+    part.m_last_modified = "Mon, 01 Jan 2019 00:00:00 GMT";
+    part.m_total = 8589934592ULL;
+    part.m_missing.push_back(DoSegment(1000, 2000));
+    part.m_missing.push_back(DoSegment(5000, 5000));    // done; not saved
+    part.m_missing.push_back(DoSegment(4294967296ULL, 8589934592ULL));
+    return part;
+}
+
+static void DoTestRoundTrip()
+{
+    DOWNLOAD_PART part = DoSamplePart();
+    std::string text = part.Serialize();
+
+    DOWNLOAD_PART loaded;
+    TEST_CHECK(loaded.Parse(text));
+    TEST_CHECK(loaded.m_url == part.m_url);
+    TEST_CHECK(loaded.m_etag == part.m_etag);
+    TEST_CHECK(loaded.m_last_modified == part.m_last_modified);
+    TEST_CHECK(loaded.m_total == part.m_total);
+    TEST_CHECK(loaded.m_missing.size() == 2);
+    if (loaded.m_missing.size() == 2)
+    {
+        TEST_CHECK(loaded.m_missing[0].m_begin == 1000);
+        TEST_CHECK(loaded.m_missing[0].m_end == 2000);
+        TEST_CHECK(!loaded.m_missing[0].m_active);
+        TEST_CHECK(loaded.m_missing[1].m_begin == 4294967296ULL);
+        TEST_CHECK(loaded.m_missing[1].m_end == 8589934592ULL);
+    }
+    TEST_CHECK(loaded.Serialize() == text);
+    TEST_CHECK(loaded.Matches(part));
+
+    // CR LF and unknown lines
+    std::string crlf;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        if (text[i] == '\n')
+            crlf += "\r";
+        crlf += text[i];
+        if (i == text.find('\n'))
+            crlf += "Comment ignored\r\n";
+    }
+    TEST_CHECK(loaded.Parse(crlf));
+    TEST_CHECK(loaded.Serialize() == text);
+
+    // no missing range: the file is complete
+    part.m_missing.clear();
+    TEST_CHECK(loaded.Parse(part.Serialize()));
+    TEST_CHECK(loaded.m_missing.empty());
+}
+
+static void DoTestMatches()
+{
+    DOWNLOAD_PART a = DoSamplePart(), b = DoSamplePart();
+    TEST_CHECK(a.GetValidator() == "\"abc\"");
+    TEST_CHECK(a.Matches(b));
+
+    // the missing ranges don't matter
+    b.m_missing.clear();
+    TEST_CHECK(a.Matches(b));
+
+    b = a;
+    b.m_etag = "\"xyz\"";
+    TEST_CHECK(!a.Matches(b));
+    b = a;
+    b.m_total += 1;
+    TEST_CHECK(!a.Matches(b));
+    b = a;
+    b.m_url += "?x";
+    TEST_CHECK(!a.Matches(b));
+
+    // the date is the validator without an ETag
+    a.m_etag.clear();
+    b = a;
+    TEST_CHECK(a.GetValidator() == a.m_last_modified);
+    TEST_CHECK(a.Matches(b));
+    b.m_last_modified = "Tue, 02 Jan 2019 00:00:00 GMT";
+    TEST_CHECK(!a.Matches(b));
+
+    // no validator, no resume
+    a.m_last_modified.clear();
+    b = a;
+    TEST_CHECK(a.GetValidator().empty());
+    TEST_CHECK(!a.Matches(b));
+}
+
+// replaces the first line starting with name
+static std::string DoReplaceLine(const std::string& text, const char *name,
+                                 const char *line)
+{
+    size_t pos = text.find(std::string("\n") + name) + 1;
+    size_t end = text.find('\n', pos);
+    return text.substr(0, pos) + line + text.substr(end);
+}
+
+static void DoTestMalformed()
+{
+    DOWNLOAD_PART part;
+    std::string text = DoSamplePart().Serialize();
+
+    // every truncation before "End" fails, even at the end of a line
+    for (size_t cb = 0; cb < text.size() - 1; ++cb)
+    {
+        TEST_CHECK(!part.Parse(text.substr(0, cb)));
+    }
+    TEST_CHECK(part.Parse(text.substr(0, text.size() - 1)));
+
+    TEST_CHECK(!part.Parse("SimpleBrowser-Part 2\nURL x\nTotal 1\nEnd\n"));
+    TEST_CHECK(!part.Parse("URL x\nTotal 1\nEnd\n"));
+    TEST_CHECK(!part.Parse("SimpleBrowser-Part 1\nTotal 1\nEnd\n"));
+    TEST_CHECK(!part.Parse("SimpleBrowser-Part 1\nURL x\nEnd\n"));
+    TEST_CHECK(!part.Parse("SimpleBrowser-Part 1\nURL x\nTotal 0\nEnd\n"));
+    TEST_CHECK(part.Parse("SimpleBrowser-Part 1\nURL x\nTotal 1\nEnd\n"));
+    TEST_CHECK(part.m_url == "x" && part.m_total == 1);
+
+    // the lines after "End" are ignored, but "End" is needed
+    TEST_CHECK(part.Parse("SimpleBrowser-Part 1\nURL x\nTotal 1\nEnd\nMissing x\n"));
+    TEST_CHECK(!part.Parse("SimpleBrowser-Part 1\nURL x\nTotal 1\n"));
+
+    TEST_CHECK(!part.Parse(DoReplaceLine(text, "Total", "Total 12x")));
+    TEST_CHECK(!part.Parse(DoReplaceLine(text, "Total", "Total -1")));
+    TEST_CHECK(!part.Parse(DoReplaceLine(text, "Total", "Total 18446744073709551616")));
+    TEST_CHECK(!part.Parse(DoReplaceLine(text, "Missing", "Missing 1000")));
+    TEST_CHECK(!part.Parse(DoReplaceLine(text, "Missing", "Missing 1000 ")));
+    TEST_CHECK(!part.Parse(DoReplaceLine(text, "Missing", "Missing abc 2000")));
+    TEST_CHECK(!part.Parse(DoReplaceLine(text, "Missing", "Missing 1000 2000 3000")));
+    TEST_CHECK(!part.Parse(DoReplaceLine(text, "Missing", "Missing 2000 1000")));
+    TEST_CHECK(!part.Parse(DoReplaceLine(text, "Missing", "Missing 1000 1000")));
+    TEST_CHECK(part.Parse(DoReplaceLine(text, "Missing", "Missing 0 1")));
+}
+
+static void DoTestMissingPastTotal()
+{
+    // the range must be in the file
+    TEST_CHECK(!DOWNLOAD_PART().Parse(
+        "SimpleBrowser-Part 1\nURL x\nTotal 100\nMissing 50 101\nEnd\n"));
+    TEST_CHECK(!DOWNLOAD_PART().Parse(
+        "SimpleBrowser-Part 1\nURL x\nTotal 100\nMissing 100 200\nEnd\n"));
+
+    DOWNLOAD_PART part;
+    TEST_CHECK(part.Parse(
+        "SimpleBrowser-Part 1\nURL x\nTotal 100\nMissing 50 100\nEnd\n"));
+    TEST_CHECK(part.m_missing.size() == 1);
+
+    // "Total" comes first
+    TEST_CHECK(!part.Parse(
+        "SimpleBrowser-Part 1\nURL x\nMissing 50 100\nTotal 100\nEnd\n"));
+}
+
+static bool DoIsRange(const char *text, SEGMENT_POS first, SEGMENT_POS last,
+                      SEGMENT_POS total)
+{
+    SEGMENT_POS f = 1, l = 1, t = 1;
+    return ParseContentRange(text, f, l, t) && f == first && l == last && t == total;
+}
+
+static bool DoIsBadRange(const char *text)
+{
+    SEGMENT_POS first, last, total;
+    return !ParseContentRange(text, first, last, total);
+}
+
+static void DoTestContentRange()
+{
+    TEST_CHECK(DoIsRange("bytes 0-0/1000", 0, 0, 1000));
+    TEST_CHECK(DoIsRange("bytes 100-199/1000", 100, 199, 1000));
+    TEST_CHECK(DoIsRange(" bytes  999-999/1000 ", 999, 999, 1000));
+    TEST_CHECK(DoIsRange("bytes 0-99/*", 0, 99, 0));
+    TEST_CHECK(DoIsRange("bytes 4294967296-4294967297/8589934592",
+                         4294967296ULL, 4294967297ULL, 8589934592ULL));
+    TEST_CHECK(DoIsRange("bytes 0-0/18446744073709551615", 0, 0, 18446744073709551615ULL));
+
+    TEST_CHECK(DoIsBadRange(""));
+    TEST_CHECK(DoIsBadRange("bytes */1000"));
+    TEST_CHECK(DoIsBadRange("items 0-0/1000"));
+    TEST_CHECK(DoIsBadRange("bytes 0-/1000"));
+    TEST_CHECK(DoIsBadRange("bytes -1-0/1000"));
+    TEST_CHECK(DoIsBadRange("bytes 0-99"));
+    TEST_CHECK(DoIsBadRange("bytes 0-99/"));
+    TEST_CHECK(DoIsBadRange("bytes 0-99/1000x"));
+    TEST_CHECK(DoIsBadRange("bytes 200-100/1000"));
+    TEST_CHECK(DoIsBadRange("bytes 0-1000/1000"));
+    TEST_CHECK(DoIsBadRange("bytes 0-0/18446744073709551616"));
+}
+
+int main(void)
+{
+    DoTestRoundTrip();
+    DoTestMatches();
+    DoTestMalformed();
+    DoTestMissingPastTotal();
+    DoTestContentRange();
+    return TEST_RESULT();
+}
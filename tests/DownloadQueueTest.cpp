@@ -0,0 +1,144 @@
+// DownloadQueueTest.cpp --- the test of DownloadQueue
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "DownloadQueue.hpp"
+#include "Test.hpp"
+
+static int s_contexts[8];
+
+static void DoTestOrder()
+{
+    // the higher priority first, and FIFO within the same priority
+    MDownloadQueue queue(8);
+    DOWNLOAD_ID id0 = queue.Add(&s_contexts[0]);
+    DOWNLOAD_ID id1 = queue.Add(&s_contexts[1], 1);
+    DOWNLOAD_ID id2 = queue.Add(&s_contexts[2]);
+    DOWNLOAD_ID id3 = queue.Add(&s_contexts[3], 1);
+    DOWNLOAD_ID id4 = queue.Add(&s_contexts[4], -1);
+    TEST_CHECK(queue.GetQueuedCount() == 5);
+
+    void *context = NULL;
+    TEST_CHECK(queue.Start(&context) == id1);
+    TEST_CHECK(context == &s_contexts[1]);
+    TEST_CHECK(queue.Start(&context) == id3);
+    TEST_CHECK(context == &s_contexts[3]);
+    TEST_CHECK(queue.Start() == id0);
+    TEST_CHECK(queue.Start() == id2);
+    TEST_CHECK(queue.Start() == id4);
+    TEST_CHECK(queue.Start() == 0);
+    TEST_CHECK(queue.GetQueuedCount() == 0);
+    TEST_CHECK(queue.GetRunningCount() == 5);
+}
+
+static void DoTestMaxRunning()
+{
+    MDownloadQueue queue(2);
+    DOWNLOAD_ID id0 = queue.Add(NULL);
+    DOWNLOAD_ID id1 = queue.Add(NULL);
+    DOWNLOAD_ID id2 = queue.Add(NULL);
+    TEST_CHECK(queue.Start() == id0);
+    TEST_CHECK(queue.Start() == id1);
+    TEST_CHECK(queue.Start() == 0);     // two are running
+    TEST_CHECK(queue.GetState(id2) == DOWNLOAD_QUEUED);
+
+    queue.Finish(id0);
+    TEST_CHECK(queue.GetState(id0) == DOWNLOAD_DONE);
+    TEST_CHECK(queue.GetRunningCount() == 1);
+    TEST_CHECK(queue.Start() == id2);
+    TEST_CHECK(queue.GetRunningCount() == 2);
+
+    // the running jobs keep running if it's decreased
+    queue.SetMaxRunning(1);
+    TEST_CHECK(queue.GetMaxRunning() == 1);
+    DOWNLOAD_ID id3 = queue.Add(NULL);
+    queue.Finish(id1);
+    TEST_CHECK(queue.Start() == 0);
+    queue.Finish(id2);
+    TEST_CHECK(queue.Start() == id3);
+
+    // zero means one
+    queue.SetMaxRunning(0);
+    TEST_CHECK(queue.GetMaxRunning() == 1);
+}
+
+static void DoTestCancel()
+{
+    MDownloadQueue queue(1);
+    DOWNLOAD_ID id0 = queue.Add(&s_contexts[0]);
+    DOWNLOAD_ID id1 = queue.Add(&s_contexts[1]);
+    DOWNLOAD_ID id2 = queue.Add(&s_contexts[2]);
+    TEST_CHECK(queue.Start() == id0);
+
+    // a running job can't be cancelled
+    TEST_CHECK(!queue.Cancel(id0));
+    TEST_CHECK(queue.GetState(id0) == DOWNLOAD_RUNNING);
+
+    TEST_CHECK(queue.Cancel(id1));
+    TEST_CHECK(queue.GetState(id1) == DOWNLOAD_CANCELLED);
+    TEST_CHECK(queue.GetContext(id1) == &s_contexts[1]);
+    TEST_CHECK(!queue.Cancel(id1));
+    TEST_CHECK(queue.GetQueuedCount() == 1);
+
+    queue.Finish(id0);
+    TEST_CHECK(queue.Start() == id2);
+    TEST_CHECK(!queue.Cancel(id2));
+    TEST_CHECK(!queue.Cancel(12345));
+}
+
+static void DoTestRemove()
+{
+    MDownloadQueue queue(1);
+    DOWNLOAD_ID id0 = queue.Add(NULL);
+    DOWNLOAD_ID id1 = queue.Add(NULL);
+    DOWNLOAD_ID id2 = queue.Add(NULL);
+    TEST_CHECK(queue.Start() == id0);
+
+    // a running job isn't removed
+    queue.Remove(id0);
+    TEST_CHECK(queue.GetState(id0) == DOWNLOAD_RUNNING);
+
+    // a queued job is removed from the queue
+    queue.Remove(id1);
+    TEST_CHECK(queue.GetState(id1) == DOWNLOAD_NONE);
+    TEST_CHECK(queue.GetContext(id1) == NULL);
+    TEST_CHECK(queue.GetQueuedCount() == 1);
+
+    queue.Finish(id0);
+    queue.Remove(id0);
+    TEST_CHECK(queue.GetState(id0) == DOWNLOAD_NONE);
+    TEST_CHECK(queue.GetRunningCount() == 0);
+    TEST_CHECK(queue.Start() == id2);
+
+    // finishing twice or an unknown job does nothing
+    queue.Finish(id2);
+    queue.Finish(id2);
+    queue.Finish(12345);
+    TEST_CHECK(queue.GetRunningCount() == 0);
+    TEST_CHECK(queue.GetState(12345) == DOWNLOAD_NONE);
+}
+
+static void DoTestIds()
+{
+    // the ids are unique and non-zero
+    MDownloadQueue queue;
+    DOWNLOAD_ID idPrev = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        DOWNLOAD_ID id = queue.Add(NULL);
+        TEST_CHECK(id != 0);
+        TEST_CHECK(id != idPrev);
+        idPrev = id;
+    }
+    TEST_CHECK(queue.GetQueuedCount() == 100);
+}
+
+int main(void)
+{
+    DoTestOrder();
+    DoTestMaxRunning();
+    DoTestCancel();
+    DoTestRemove();
+    DoTestIds();
+    return TEST_RESULT();
+}
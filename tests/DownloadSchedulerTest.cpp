@@ -0,0 +1,151 @@
+// DownloadSchedulerTest.cpp --- the test of DownloadScheduler
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+// NOTE: This test uses Win32 API. It's built on Win32 only.
+
+#include "DownloadScheduler.hpp"
+#include "Test.hpp"
+
+// a job that runs until released
+struct TEST_JOB
+{
+    HANDLE m_hRelease;
+    LONG m_nRuns;
+};
+
+static void DoTestProc(DOWNLOAD_ID id, void *context)
+{
+    TEST_JOB *job = (TEST_JOB *)context;
+    InterlockedIncrement(&job->m_nRuns);
+    WaitForSingleObject(job->m_hRelease, INFINITE);
+}
+
+static void DoInitJob(TEST_JOB& job)
+{
+    job.m_hRelease = CreateEventW(NULL, TRUE, FALSE, NULL);
+    job.m_nRuns = 0;
+}
+
+static void DoFreeJob(TEST_JOB& job)
+{
+    CloseHandle(job.m_hRelease);
+}
+
+// the finished jobs are removed, so they become DOWNLOAD_NONE
+static bool DoWaitForState(MDownloadScheduler& scheduler, DOWNLOAD_ID id,
+                           DOWNLOAD_STATE state)
+{
+    for (int i = 0; i < 5000; ++i)
+    {
+        if (scheduler.GetState(id) == state)
+            return true;
+        Sleep(1);
+    }
+    return false;
+}
+
+static void DoTestWakeup()
+{
+    TEST_JOB a, b, c;
+    DoInitJob(a);
+    DoInitJob(b);
+    DoInitJob(c);
+    {
+        MDownloadScheduler scheduler(DoTestProc);
+        scheduler.SetMaxRunning(1);
+        DOWNLOAD_ID idA = scheduler.Add(&a);
+        DOWNLOAD_ID idB = scheduler.Add(&b);
+        TEST_CHECK(idA && idB);
+        TEST_CHECK(DoWaitForState(scheduler, idA, DOWNLOAD_RUNNING));
+        Sleep(50);
+        TEST_CHECK(scheduler.GetState(idB) == DOWNLOAD_QUEUED);
+
+        // a new slot wakes a worker
+        scheduler.SetMaxRunning(2);
+        TEST_CHECK(DoWaitForState(scheduler, idB, DOWNLOAD_RUNNING));
+
+        // a finished job wakes a worker
+        DOWNLOAD_ID idC = scheduler.Add(&c);
+        Sleep(50);
+        TEST_CHECK(scheduler.GetState(idC) == DOWNLOAD_QUEUED);
+        SetEvent(a.m_hRelease);
+        TEST_CHECK(DoWaitForState(scheduler, idA, DOWNLOAD_NONE));
+        TEST_CHECK(DoWaitForState(scheduler, idC, DOWNLOAD_RUNNING));
+
+        SetEvent(b.m_hRelease);
+        SetEvent(c.m_hRelease);
+        TEST_CHECK(DoWaitForState(scheduler, idB, DOWNLOAD_NONE));
+        TEST_CHECK(DoWaitForState(scheduler, idC, DOWNLOAD_NONE));
+        TEST_CHECK(scheduler.Stop(INFINITE));
+    }
+    TEST_CHECK(a.m_nRuns == 1 && b.m_nRuns == 1 && c.m_nRuns == 1);
+    DoFreeJob(a);
+    DoFreeJob(b);
+    DoFreeJob(c);
+}
+
+static void DoTestCancel()
+{
+    TEST_JOB a, b;
+    DoInitJob(a);
+    DoInitJob(b);
+    {
+        MDownloadScheduler scheduler(DoTestProc);
+        DOWNLOAD_ID idA = scheduler.Add(&a);
+        DOWNLOAD_ID idB = scheduler.Add(&b);
+        TEST_CHECK(DoWaitForState(scheduler, idA, DOWNLOAD_RUNNING));
+
+        // only a queued job can be cancelled
+        TEST_CHECK(!scheduler.Cancel(idA));
+        TEST_CHECK(scheduler.Cancel(idB));
+        TEST_CHECK(scheduler.GetState(idB) == DOWNLOAD_NONE);
+
+        SetEvent(a.m_hRelease);
+        SetEvent(b.m_hRelease);
+        TEST_CHECK(DoWaitForState(scheduler, idA, DOWNLOAD_NONE));
+    }
+    TEST_CHECK(a.m_nRuns == 1);
+    TEST_CHECK(b.m_nRuns == 0);
+    DoFreeJob(a);
+    DoFreeJob(b);
+}
+
+static void DoTestStop()
+{
+    TEST_JOB a, b;
+    DoInitJob(a);
+    DoInitJob(b);
+    {
+        MDownloadScheduler scheduler(DoTestProc);
+        DOWNLOAD_ID idA = scheduler.Add(&a);
+        DOWNLOAD_ID idB = scheduler.Add(&b);
+        TEST_CHECK(DoWaitForState(scheduler, idA, DOWNLOAD_RUNNING));
+
+        // the running job blocks it
+        TEST_CHECK(!scheduler.Stop(50));
+        TEST_CHECK(scheduler.GetState(idA) == DOWNLOAD_RUNNING);
+
+        // it can be called again
+        SetEvent(a.m_hRelease);
+        TEST_CHECK(scheduler.Stop(INFINITE));
+        TEST_CHECK(scheduler.GetState(idA) == DOWNLOAD_NONE);
+
+        // the queued job is dropped, and its owner frees it
+        TEST_CHECK(scheduler.GetState(idB) == DOWNLOAD_QUEUED);
+        TEST_CHECK(scheduler.Cancel(idB));
+        TEST_CHECK(scheduler.Stop(0));
+    }
+    TEST_CHECK(a.m_nRuns == 1);
+    TEST_CHECK(b.m_nRuns == 0);
+    DoFreeJob(a);
+    DoFreeJob(b);
+}
+
+int main(void)
+{
+    DoTestWakeup();
+    DoTestCancel();
+    DoTestStop();
+    return TEST_RESULT();
+}
@@ -0,0 +1,43 @@
+// LayoutEngineBench.cpp --- the benchmark of LayoutEngine
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "LayoutEngine.hpp"
+#include "Test.hpp"
+#include <vector>
+#include <chrono>
+
+// a bar of 1000 buttons, every tenth one is "*"
+#define BENCH_BUTTONS   1000
+#define BENCH_LOOPS     10000
+
+int main(void)
+{
+    std::vector<LAYOUT_SPEC> specs(BENCH_BUTTONS);
+    for (size_t i = 0; i < specs.size(); ++i)
+    {
+        specs[i].m_star = (i % 10 == 5);
+        specs[i].m_size = 16 + int(i % 7);
+    }
+    std::vector<LAYOUT_RECT> rects(specs.size());
+
+    LAYOUT_RECT rcBar = { 0, 0, 0, 24 };
+    int sum = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int k = 0; k < BENCH_LOOPS; ++k)
+    {
+        // the width changes like dragging the window frame
+        rcBar.right = 20000 + (k % 100) * 16;
+        LayoutBar(rcBar, false, &specs[0], specs.size(), &rects[0]);
+        sum += rects.back().right;
+    }
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+
+    double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    std::printf("LayoutBar: %d buttons: %.0f ns per layout\n", BENCH_BUTTONS, ns / BENCH_LOOPS);
+
+    // the last button ends at the end of the bar
+    TEST_CHECK(rects.back().right == rcBar.right);
+    TEST_CHECK(sum != 0);
+    return TEST_RESULT();
+}
@@ -0,0 +1,207 @@
+// LayoutEngineTest.cpp --- the test of LayoutEngine
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "LayoutEngine.hpp"
+#include "Test.hpp"
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// the number of the allocations of this program
+static size_t s_nAllocCount = 0;
+
+void *operator new(size_t size)
+{
+    ++s_nAllocCount;
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+static const LAYOUT_SPEC STAR = { 0, true };
+
+static LAYOUT_SPEC DoFixed(int size)
+{
+    LAYOUT_SPEC spec = { size, false };
+    return spec;
+}
+
+static bool DoIsRect(const LAYOUT_RECT& rc, int left, int top, int right, int bottom)
+{
+    return rc.left == left && rc.top == top && rc.right == right && rc.bottom == bottom;
+}
+
+static void DoTestFixed()
+{
+    LAYOUT_RECT rcBar = { 0, 0, 100, 20 };
+    LAYOUT_SPEC specs[] = { DoFixed(30), DoFixed(40) };
+    LAYOUT_RECT rects[2];
+    LayoutBar(rcBar, false, specs, 2, rects);
+    TEST_CHECK(DoIsRect(rects[0], 0, 0, 30, 20));
+    TEST_CHECK(DoIsRect(rects[1], 30, 0, 70, 20));
+}
+
+static void DoTestFixedClipped()
+{
+    // the buttons beyond the bar are clipped, not overlapped
+    LAYOUT_RECT rcBar = { 10, 5, 110, 25 };
+    LAYOUT_SPEC specs[] = { DoFixed(60), DoFixed(60), DoFixed(10) };
+    LAYOUT_RECT rects[3];
+    LayoutBar(rcBar, false, specs, 3, rects);
+    TEST_CHECK(DoIsRect(rects[0], 10, 5, 70, 25));
+    TEST_CHECK(DoIsRect(rects[1], 70, 5, 110, 25));
+    TEST_CHECK(DoIsRect(rects[2], 110, 5, 110, 25));
+}
+
+static void DoTestStar()
+{
+    // the star takes the rest between the start and the end buttons
+    LAYOUT_RECT rcBar = { 0, 0, 100, 20 };
+    LAYOUT_SPEC specs[] = { DoFixed(20), STAR, DoFixed(30) };
+    LAYOUT_RECT rects[3];
+    LayoutBar(rcBar, false, specs, 3, rects);
+    TEST_CHECK(DoIsRect(rects[0], 0, 0, 20, 20));
+    TEST_CHECK(DoIsRect(rects[1], 20, 0, 70, 20));
+    TEST_CHECK(DoIsRect(rects[2], 70, 0, 100, 20));
+}
+
+static void DoTestStarRemainder()
+{
+    // the remainder goes to the first stars
+    LAYOUT_RECT rcBar = { 0, 0, 101, 20 };
+    LAYOUT_SPEC specs[] = { STAR, STAR };
+    LAYOUT_RECT rects[2];
+    LayoutBar(rcBar, false, specs, 2, rects);
+    TEST_CHECK(DoIsRect(rects[0], 0, 0, 51, 20));
+    TEST_CHECK(DoIsRect(rects[1], 51, 0, 101, 20));
+}
+
+static void DoTestFixedBetweenStars()
+{
+    // the fixed button between the stars takes its room first
+    LAYOUT_RECT rcBar = { 0, 0, 100, 20 };
+    LAYOUT_SPEC specs[] = { STAR, DoFixed(10), STAR };
+    LAYOUT_RECT rects[3];
+    LayoutBar(rcBar, false, specs, 3, rects);
+    TEST_CHECK(DoIsRect(rects[0], 0, 0, 45, 20));
+    TEST_CHECK(DoIsRect(rects[1], 45, 0, 55, 20));
+    TEST_CHECK(DoIsRect(rects[2], 55, 0, 100, 20));
+}
+
+static void DoTestStarNoRoom()
+{
+    // the fixed buttons fill the bar and the star gets nothing
+    LAYOUT_RECT rcBar = { 0, 0, 100, 20 };
+    LAYOUT_SPEC specs[] = { DoFixed(80), STAR, DoFixed(80) };
+    LAYOUT_RECT rects[3];
+    LayoutBar(rcBar, false, specs, 3, rects);
+    TEST_CHECK(DoIsRect(rects[0], 0, 0, 80, 20));
+    TEST_CHECK(DoIsRect(rects[1], 80, 0, 80, 20));
+    TEST_CHECK(DoIsRect(rects[2], 80, 0, 100, 20));
+}
+
+static void DoTestVertical()
+{
+    LAYOUT_RECT rcBar = { 0, 10, 24, 110 };
+    LAYOUT_SPEC specs[] = { DoFixed(30), STAR, DoFixed(20) };
+    LAYOUT_RECT rects[3];
+    LayoutBar(rcBar, true, specs, 3, rects);
+    TEST_CHECK(DoIsRect(rects[0], 0, 10, 24, 40));
+    TEST_CHECK(DoIsRect(rects[1], 0, 40, 24, 90));
+    TEST_CHECK(DoIsRect(rects[2], 0, 90, 24, 110));
+}
+
+static void DoTestEmpty()
+{
+    LAYOUT_RECT rcBar = { 0, 0, 100, 20 };
+    LayoutBar(rcBar, false, NULL, 0, NULL);
+
+    // a zero-sized bar gives zero-sized buttons
+    LAYOUT_RECT rcEmpty = { 0, 0, 0, 20 };
+    LAYOUT_SPEC specs[] = { DoFixed(10), STAR };
+    LAYOUT_RECT rects[2];
+    LayoutBar(rcEmpty, false, specs, 2, rects);
+    TEST_CHECK(DoIsRect(rects[0], 0, 0, 0, 20));
+    TEST_CHECK(DoIsRect(rects[1], 0, 0, 0, 20));
+}
+
+static void DoTestMoved()
+{
+    LAYOUT_RECT rects[4] = { { 0, 0, 10, 20 }, { 10, 0, 20, 20 }, { 20, 0, 30, 20 }, { 30, 0, 40, 20 } };
+    LAYOUT_RECT applied[4] = { { 0, 0, 10, 20 }, { 10, 0, 25, 20 }, { 20, 0, 30, 20 }, { -1, -1, -1, -1 } };
+    TEST_CHECK(FindMovedButton(rects, applied, 4, 0) == 1);
+    TEST_CHECK(FindMovedButton(rects, applied, 4, 1) == 1);
+    TEST_CHECK(FindMovedButton(rects, applied, 4, 2) == 3);
+    TEST_CHECK(FindMovedButton(rects, applied, 4, 4) == 4);
+    TEST_CHECK(FindMovedButton(rects, applied, 3, 2) == 3);
+    TEST_CHECK(FindMovedButton(rects, applied, 0, 0) == 0);
+}
+
+// the resize pass of DoResizeSide: the layout and the diff
+static size_t DoResizePass(const LAYOUT_RECT& rcBar, const std::vector<LAYOUT_SPEC>& specs,
+                           std::vector<LAYOUT_RECT>& rects, std::vector<LAYOUT_RECT>& applied)
+{
+    size_t moved = 0;
+    const size_t count = specs.size();
+    LayoutBar(rcBar, false, &specs[0], count, &rects[0]);
+    for (size_t i = 0; (i = FindMovedButton(&rects[0], &applied[0], count, i)) < count; ++i)
+    {
+        applied[i] = rects[i];
+        ++moved;
+    }
+    return moved;
+}
+
+static void DoTestNoAllocation()
+{
+    // a bar of "*" in the middle, like Upside.txt
+    std::vector<LAYOUT_SPEC> specs;
+    for (int i = 0; i < 100; ++i)
+    {
+        specs.push_back(i == 50 ? STAR : DoFixed(16 + i % 5));
+    }
+    std::vector<LAYOUT_RECT> rects(specs.size());
+    LAYOUT_RECT rcNone = { -1, -1, -1, -1 };
+    std::vector<LAYOUT_RECT> applied(specs.size(), rcNone);
+
+    LAYOUT_RECT rcBar = { 0, 0, 3000, 24 };
+    TEST_CHECK(DoResizePass(rcBar, specs, rects, applied) == specs.size());
+    TEST_CHECK(DoResizePass(rcBar, specs, rects, applied) == 0);
+
+    // dragging the window frame moves the buttons after the "*" only
+    size_t nAllocCount = s_nAllocCount;
+    size_t moved = 0;
+    for (int k = 1; k <= 100; ++k)
+    {
+        rcBar.right = 3000 + k;
+        moved += DoResizePass(rcBar, specs, rects, applied);
+    }
+    TEST_CHECK(s_nAllocCount == nAllocCount);
+    TEST_CHECK(moved == 100 * 50);
+
+    // the counter works
+    std::vector<int> probe(1);
+    TEST_CHECK(s_nAllocCount == nAllocCount + 1);
+}
+
+int main(void)
+{
+    DoTestFixed();
+    DoTestFixedClipped();
+    DoTestStar();
+    DoTestStarRemainder();
+    DoTestFixedBetweenStars();
+    DoTestStarNoRoom();
+    DoTestVertical();
+    DoTestEmpty();
+    DoTestMoved();
+    DoTestNoAllocation();
+    return TEST_RESULT();
+}
@@ -0,0 +1,191 @@
+// RateEstimatorTest.cpp --- the test of RateEstimator
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "RateEstimator.hpp"
+#include "Test.hpp"
+#include <cmath>
+
+// NOTE: The ticks are given by the tests as a fake clock.
+
+// the rates are computed in double
+static bool DoIsNear(double value, double expected)
+{
+    return std::fabs(value - expected) <= expected * 1e-9 + 1e-9;
+}
+
+// adds count samples of rate bytes per second, every interval milliseconds
+static RATE_BYTES DoFeed(MRateEstimator& estimator, RATE_BYTES received, RATE_TICK& tick,
+                         int count, RATE_BYTES rate, RATE_TICK interval)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        received += rate * interval / 1000;
+        tick += interval;
+        estimator.Update(received, tick);
+    }
+    return received;
+}
+
+static void DoTestEmpty()
+{
+    MRateEstimator estimator;
+    unsigned long seconds = 123;
+    TEST_CHECK(estimator.GetRate() == 0);
+    TEST_CHECK(!estimator.GetRemainingSeconds(1000, seconds));
+    TEST_CHECK(seconds == 123);
+
+    // the first sample is the base
+    estimator.Update(5000, 100);
+    TEST_CHECK(estimator.GetRate() == 0);
+    TEST_CHECK(estimator.GetWindowRate() == 0);
+    TEST_CHECK(!estimator.GetRemainingSeconds(10000, seconds));
+}
+
+static void DoTestConstant()
+{
+    MRateEstimator estimator;
+    RATE_TICK tick = 1000;
+    estimator.Update(0, tick);
+    RATE_BYTES received = DoFeed(estimator, 0, tick, 10, 10000, 100);
+    TEST_CHECK(received == 10000);
+    TEST_CHECK(DoIsNear(estimator.GetWindowRate(), 10000));
+    TEST_CHECK(DoIsNear(estimator.GetSmoothRate(), 10000));
+    TEST_CHECK(DoIsNear(estimator.GetRate(), 10000));
+
+    unsigned long seconds = 0;
+    TEST_CHECK(estimator.GetRemainingSeconds(received + 50000, seconds));
+    TEST_CHECK(seconds == 5);
+
+    // rounded up
+    TEST_CHECK(estimator.GetRemainingSeconds(received + 25000, seconds));
+    TEST_CHECK(seconds == 3);
+
+    // done
+    TEST_CHECK(estimator.GetRemainingSeconds(received, seconds));
+    TEST_CHECK(seconds == 0);
+    TEST_CHECK(estimator.GetRemainingSeconds(received - 1, seconds));
+    TEST_CHECK(seconds == 0);
+}
+
+static void DoTestWrapAround()
+{
+    // the tick wraps around in the middle
+    MRateEstimator estimator;
+    RATE_TICK tick = RATE_TICK(0) - 500;
+    estimator.Update(0, tick);
+    DoFeed(estimator, 0, tick, 10, 2000, 100);
+    TEST_CHECK(tick == 500);
+    TEST_CHECK(DoIsNear(estimator.GetWindowRate(), 2000));
+    TEST_CHECK(DoIsNear(estimator.GetSmoothRate(), 2000));
+}
+
+static void DoTestSameTick()
+{
+    // a sample at the same tick is ignored
+    MRateEstimator estimator;
+    estimator.Update(0, 0);
+    estimator.Update(1000, 1000);
+    estimator.Update(5000, 1000);
+    TEST_CHECK(DoIsNear(estimator.GetWindowRate(), 1000));
+}
+
+static void DoTestWindow()
+{
+    // the old samples go out of the window
+    MRateEstimator estimator;
+    RATE_TICK tick = 0;
+    estimator.Update(0, tick);
+    RATE_BYTES received = DoFeed(estimator, 0, tick, RATE_WINDOW_SIZE, 1000, 100);
+    TEST_CHECK(DoIsNear(estimator.GetWindowRate(), 1000));
+
+    // RATE_WINDOW_SIZE samples have RATE_WINDOW_SIZE - 1 intervals
+    received = DoFeed(estimator, received, tick, RATE_WINDOW_SIZE / 2, 3000, 100);
+    const int nNew = RATE_WINDOW_SIZE / 2, nOld = RATE_WINDOW_SIZE - 1 - nNew;
+    double rate = double(nNew * 300 + nOld * 100) * 1000 / ((nNew + nOld) * 100);
+    TEST_CHECK(DoIsNear(estimator.GetWindowRate(), rate));
+
+    DoFeed(estimator, received, tick, RATE_WINDOW_SIZE, 3000, 100);
+    TEST_CHECK(DoIsNear(estimator.GetWindowRate(), 3000));
+
+    // the EWMA approaches it too
+    TEST_CHECK(estimator.GetSmoothRate() > 2000);
+    TEST_CHECK(estimator.GetSmoothRate() < 3000);
+}
+
+static void DoTestSmooth()
+{
+    // the weight depends on the interval, not on the number of the samples
+    MRateEstimator estimator1, estimator2;
+    RATE_TICK tick1 = 0, tick2 = 0;
+    estimator1.Update(0, tick1);
+    estimator2.Update(0, tick2);
+    RATE_BYTES received1 = DoFeed(estimator1, 0, tick1, 1, 1000, 1000);
+    RATE_BYTES received2 = DoFeed(estimator2, 0, tick2, 1, 1000, 1000);
+
+    DoFeed(estimator1, received1, tick1, 1, 5000, 1000);
+    DoFeed(estimator2, received2, tick2, 10, 5000, 100);
+    TEST_CHECK(tick1 == tick2);
+    TEST_CHECK(std::fabs(estimator1.GetSmoothRate() - estimator2.GetSmoothRate()) < 1e-6);
+
+    double alpha = 1 - std::exp(-1000.0 / RATE_SMOOTHING_TIME);
+    TEST_CHECK(DoIsNear(estimator1.GetSmoothRate(), 1000 + alpha * 4000));
+}
+
+static void DoTestStall()
+{
+    // no progress over the window is a stall
+    MRateEstimator estimator;
+    RATE_TICK tick = 0;
+    estimator.Update(0, tick);
+    RATE_BYTES received = DoFeed(estimator, 0, tick, 10, 10000, 100);
+    DoFeed(estimator, received, tick, RATE_WINDOW_SIZE, 0, 100);
+    TEST_CHECK(estimator.GetRate() == 0);
+    TEST_CHECK(estimator.GetSmoothRate() > 0);
+
+    unsigned long seconds;
+    TEST_CHECK(!estimator.GetRemainingSeconds(received + 1000, seconds));
+}
+
+static void DoTestTooLong()
+{
+    MRateEstimator estimator;
+    RATE_TICK tick = 0;
+    estimator.Update(0, tick);
+    RATE_BYTES received = DoFeed(estimator, 0, tick, 10, 1000, 1000);
+
+    unsigned long seconds;
+    RATE_BYTES rest = RATE_BYTES(RATE_MAX_REMAINING) * 1000;
+    TEST_CHECK(estimator.GetRemainingSeconds(received + rest, seconds));
+    TEST_CHECK(seconds == RATE_MAX_REMAINING);
+    TEST_CHECK(!estimator.GetRemainingSeconds(received + rest + 1000, seconds));
+}
+
+static void DoTestRestart()
+{
+    // fewer bytes than before: the download restarted
+    MRateEstimator estimator;
+    RATE_TICK tick = 0;
+    estimator.Update(0, tick);
+    DoFeed(estimator, 0, tick, 10, 10000, 100);
+    estimator.Update(500, tick + 100);
+    TEST_CHECK(estimator.GetRate() == 0);
+    TEST_CHECK(estimator.GetSmoothRate() == 0);
+
+    estimator.Update(1500, tick + 600);
+    TEST_CHECK(DoIsNear(estimator.GetRate(), 2000));
+}
+
+int main(void)
+{
+    DoTestEmpty();
+    DoTestConstant();
+    DoTestWrapAround();
+    DoTestSameTick();
+    DoTestWindow();
+    DoTestSmooth();
+    DoTestStall();
+    DoTestTooLong();
+    DoTestRestart();
+    return TEST_RESULT();
+}
@@ -0,0 +1,192 @@
+// SegmentPlannerTest.cpp --- the test of SegmentPlanner
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "SegmentPlanner.hpp"
+#include "Test.hpp"
+
+static bool DoIsSegment(const MSegmentPlanner& planner, int i,
+                        SEGMENT_POS begin, SEGMENT_POS end)
+{
+    const DOWNLOAD_SEGMENT& segment = planner.GetSegment(i);
+    return segment.m_begin == begin && segment.m_end == end;
+}
+
+// writes cb bytes of the segment
+static SEGMENT_POS DoWrite(MSegmentPlanner& planner, int i, SEGMENT_POS cb)
+{
+    SEGMENT_POS cbWrite = planner.Reserve(i, cb);
+    planner.Advance(i, cbWrite);
+    return cbWrite;
+}
+
+static void DoTestPlan()
+{
+    MSegmentPlanner planner;
+    planner.Plan(1000, 4, 100);
+    TEST_CHECK(planner.GetCount() == 4);
+    TEST_CHECK(DoIsSegment(planner, 0, 0, 250));
+    TEST_CHECK(DoIsSegment(planner, 1, 250, 500));
+    TEST_CHECK(DoIsSegment(planner, 2, 500, 750));
+    TEST_CHECK(DoIsSegment(planner, 3, 750, 1000));
+    TEST_CHECK(planner.GetTotal() == 1000);
+    TEST_CHECK(planner.GetReceived() == 0);
+    TEST_CHECK(!planner.IsDone());
+
+    // the last one takes the remainder
+    planner.Plan(1003, 2, 100);
+    TEST_CHECK(planner.GetCount() == 2);
+    TEST_CHECK(DoIsSegment(planner, 0, 0, 501));
+    TEST_CHECK(DoIsSegment(planner, 1, 501, 1003));
+
+    // not below the minimum size
+    planner.Plan(1000, 8, 300);
+    TEST_CHECK(planner.GetCount() == 3);
+    TEST_CHECK(DoIsSegment(planner, 2, 666, 1000));
+
+    // at least one
+    planner.Plan(10, 4, 100);
+    TEST_CHECK(planner.GetCount() == 1);
+    TEST_CHECK(DoIsSegment(planner, 0, 0, 10));
+    planner.Plan(1000, 0, 0);
+    TEST_CHECK(planner.GetCount() == 1);
+}
+
+static void DoTestAdvance()
+{
+    MSegmentPlanner planner;
+    planner.Plan(1000, 2, 100);
+    TEST_CHECK(planner.Take() == 0);
+    TEST_CHECK(planner.Take() == 1);
+
+    TEST_CHECK(DoWrite(planner, 0, 100) == 100);
+    TEST_CHECK(DoIsSegment(planner, 0, 100, 500));
+    TEST_CHECK(planner.GetReceived() == 100);
+
+    // a failed write doesn't advance it
+    TEST_CHECK(planner.Reserve(0, 100) == 100);
+    planner.Advance(0, 0);
+    TEST_CHECK(DoIsSegment(planner, 0, 100, 500));
+    TEST_CHECK(planner.GetReceived() == 100);
+
+    // not beyond the end
+    TEST_CHECK(DoWrite(planner, 0, 1000) == 400);
+    TEST_CHECK(planner.IsSegmentDone(0));
+    TEST_CHECK(!planner.IsSegmentDone(1));
+    TEST_CHECK(!planner.IsDone());
+
+    // a short write advances by the written bytes
+    TEST_CHECK(planner.Reserve(1, 300) == 300);
+    planner.Advance(1, 200);
+    TEST_CHECK(DoIsSegment(planner, 1, 700, 1000));
+    TEST_CHECK(DoWrite(planner, 1, 300) == 300);
+    TEST_CHECK(planner.IsSegmentDone(1));
+    TEST_CHECK(planner.IsDone());
+    TEST_CHECK(planner.GetReceived() == 1000);
+}
+
+static void DoTestSteal()
+{
+    MSegmentPlanner planner;
+    planner.Plan(1000, 2, 100);
+    TEST_CHECK(planner.Take() == 0);
+    TEST_CHECK(planner.Take() == 1);
+
+    // the second half of the largest one
+    TEST_CHECK(DoWrite(planner, 1, 100) == 100);     // [600, 1000)
+    TEST_CHECK(planner.Take() == 2);
+    TEST_CHECK(DoIsSegment(planner, 0, 0, 250));
+    TEST_CHECK(DoIsSegment(planner, 2, 250, 500));
+
+    // the stolen end isn't written by the first worker
+    TEST_CHECK(DoWrite(planner, 0, 300) == 250);
+    TEST_CHECK(planner.IsSegmentDone(0));
+
+    // a finished slot is reused
+    planner.Release(0);
+    TEST_CHECK(planner.Take() == 0);
+    TEST_CHECK(DoIsSegment(planner, 1, 600, 800));
+    TEST_CHECK(DoIsSegment(planner, 0, 800, 1000));
+    TEST_CHECK(planner.GetCount() == 3);
+
+    // too small to steal
+    TEST_CHECK(DoWrite(planner, 0, 50) == 50);
+    TEST_CHECK(DoWrite(planner, 1, 50) == 50);
+    TEST_CHECK(DoWrite(planner, 2, 100) == 100);
+    TEST_CHECK(planner.Take() == -1);
+}
+
+static void DoTestStealWriting()
+{
+    // the bytes being written are not stolen
+    MSegmentPlanner planner;
+    planner.Plan(1000, 1, 100);
+    TEST_CHECK(planner.Take() == 0);
+    TEST_CHECK(planner.Reserve(0, 400) == 400);
+    TEST_CHECK(planner.Take() == 1);
+    TEST_CHECK(DoIsSegment(planner, 0, 0, 700));
+    TEST_CHECK(DoIsSegment(planner, 1, 700, 1000));
+
+    planner.Advance(0, 400);
+    TEST_CHECK(DoIsSegment(planner, 0, 400, 700));
+    TEST_CHECK(planner.GetReceived() == 400);
+}
+
+static void DoTestRelease()
+{
+    // a failed segment is taken again
+    MSegmentPlanner planner;
+    planner.Plan(1000, 2, 100);
+    TEST_CHECK(planner.Take() == 0);
+    TEST_CHECK(planner.Take() == 1);
+    TEST_CHECK(planner.Reserve(0, 100) == 100);
+    planner.Release(0);
+    TEST_CHECK(planner.Take() == 0);
+    TEST_CHECK(DoIsSegment(planner, 0, 0, 500));
+    TEST_CHECK(planner.GetReceived() == 0);
+}
+
+static void DoTestSetSegments()
+{
+    std::vector<DOWNLOAD_SEGMENT> segments;
+    DOWNLOAD_SEGMENT segment = { 100, 300, true, 50 };
+    segments.push_back(segment);
+    segment.m_begin = 500;
+    segment.m_end = 500;        // empty
+    segments.push_back(segment);
+    segment.m_begin = 900;
+    segment.m_end = 1200;       // beyond the total
+    segments.push_back(segment);
+
+    MSegmentPlanner planner;
+    planner.SetSegments(1000, segments);
+    TEST_CHECK(planner.GetCount() == 2);
+    TEST_CHECK(DoIsSegment(planner, 0, 100, 300));
+    TEST_CHECK(DoIsSegment(planner, 1, 900, 1000));
+    TEST_CHECK(!planner.GetSegment(0).m_active);
+    TEST_CHECK(planner.GetSegment(0).m_writing == 0);
+    TEST_CHECK(planner.GetReceived() == 700);
+
+    TEST_CHECK(planner.Take() == 0);
+    TEST_CHECK(planner.Take() == 1);
+    TEST_CHECK(DoWrite(planner, 0, 200) == 200);
+    TEST_CHECK(DoWrite(planner, 1, 100) == 100);
+    TEST_CHECK(planner.IsDone());
+
+    // nothing is missing
+    segments.clear();
+    planner.SetSegments(1000, segments);
+    TEST_CHECK(planner.IsDone());
+    TEST_CHECK(planner.Take() == -1);
+}
+
+int main(void)
+{
+    DoTestPlan();
+    DoTestAdvance();
+    DoTestSteal();
+    DoTestStealWriting();
+    DoTestRelease();
+    DoTestSetSegments();
+    return TEST_RESULT();
+}
@@ -0,0 +1,72 @@
+// SettingsSerializerBench.cpp --- the benchmark of SettingsSerializer
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "SettingsSerializer.hpp"
+#include "Test.hpp"
+#include <chrono>
+
+// the settings with a long history of the address bar
+#define BENCH_NUMBERS   32
+#define BENCH_URLS      1000
+#define BENCH_LOOPS     200
+
+class MBenchValues : public MSerialValues
+{
+public:
+    unsigned long m_numbers[BENCH_NUMBERS];
+    std::wstring m_homepage;
+    list_type m_urls;
+
+    virtual unsigned long GetNumber(size_t i) const { return m_numbers[i]; }
+    virtual const std::wstring& GetString(size_t i) const { return m_homepage; }
+    virtual const list_type& GetList(size_t i) const { return m_urls; }
+    virtual void SetNumber(size_t i, unsigned long value) { m_numbers[i] = value; }
+    virtual void SetString(size_t i, std::wstring& value) { m_homepage.swap(value); }
+    virtual void SetList(size_t i, list_type& value) { m_urls.swap(value); }
+};
+
+int main(void)
+{
+    static wchar_t s_names[BENCH_NUMBERS][16];
+    std::vector<SERIAL_FIELD> fields;
+    for (int i = 0; i < BENCH_NUMBERS; ++i)
+    {
+        std::swprintf(s_names[i], 16, L"Number%d", i);
+        SERIAL_FIELD field = { s_names[i], SERIAL_NUMBER };
+        fields.push_back(field);
+    }
+    SERIAL_FIELD homepage = { L"HomePage", SERIAL_STRING };
+    SERIAL_FIELD urls = { L"URL", SERIAL_LIST };
+    fields.push_back(homepage);
+    fields.push_back(urls);
+
+    MBenchValues values;
+    for (int i = 0; i < BENCH_NUMBERS; ++i)
+        values.m_numbers[i] = i * 1000;
+    values.m_homepage = L"https://www.example.com/";
+    for (int i = 0; i < BENCH_URLS; ++i)
+        values.m_urls.push_back(L"https://www.example.com/path/to/page" + std::to_wstring(i) + L".html");
+
+    MSettingsSerializer serializer(&fields[0], fields.size());
+    std::string data;
+    MBenchValues loaded;
+    bool ok = true;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int k = 0; k < BENCH_LOOPS; ++k)
+        serializer.Serialize(values, data);
+    std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+    for (int k = 0; k < BENCH_LOOPS; ++k)
+        ok = serializer.Deserialize(loaded, data) && ok;
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    double us1 = double(std::chrono::duration_cast<std::chrono::nanoseconds>(middle - start).count()) / 1000;
+    double us2 = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - middle).count()) / 1000;
+    std::printf("MSettingsSerializer: %d URLs, %u bytes: Serialize %.1f us, Deserialize %.1f us\n",
+                BENCH_URLS, unsigned(data.size()), us1 / BENCH_LOOPS, us2 / BENCH_LOOPS);
+
+    TEST_CHECK(ok);
+    TEST_CHECK(loaded.m_urls == values.m_urls);
+    return TEST_RESULT();
+}
@@ -0,0 +1,171 @@
+// SettingsSerializerTest.cpp --- the test of SettingsSerializer
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "SettingsSerializer.hpp"
+#include "Test.hpp"
+
+#define FIELD_COUNT 4
+
+// the values of a schema of FIELD_COUNT fields at most
+class MTestValues : public MSerialValues
+{
+public:
+    unsigned long m_numbers[FIELD_COUNT];
+    std::wstring m_strings[FIELD_COUNT];
+    list_type m_lists[FIELD_COUNT];
+    int m_sets;
+
+    MTestValues() : m_sets(0)
+    {
+        for (size_t i = 0; i < FIELD_COUNT; ++i)
+            m_numbers[i] = 0;
+    }
+
+    virtual unsigned long GetNumber(size_t i) const { return m_numbers[i]; }
+    virtual const std::wstring& GetString(size_t i) const { return m_strings[i]; }
+    virtual const list_type& GetList(size_t i) const { return m_lists[i]; }
+
+    virtual void SetNumber(size_t i, unsigned long value)
+    {
+        m_numbers[i] = value;
+        ++m_sets;
+    }
+    virtual void SetString(size_t i, std::wstring& value)
+    {
+        m_strings[i].swap(value);
+        ++m_sets;
+    }
+    virtual void SetList(size_t i, list_type& value)
+    {
+        m_lists[i].swap(value);
+        ++m_sets;
+    }
+};
+
+static const SERIAL_FIELD s_fields[FIELD_COUNT] =
+{
+    { L"Width", SERIAL_NUMBER },
+    { L"HomePage", SERIAL_STRING },
+    { L"URL", SERIAL_LIST },
+    { L"Secure", SERIAL_NUMBER },
+};
+
+static void DoFill(MTestValues& values)
+{
+    values.m_numbers[0] = 0xFFFFFFFF;
+    values.m_strings[1] = L"http://\x65E5\x672C.example/\xD83D\xDE00";
+    values.m_lists[2].push_back(L"http://a.example/");
+    values.m_lists[2].push_back(L"");
+    values.m_lists[2].push_back(std::wstring(200, L'x'));
+    values.m_numbers[3] = 1;
+}
+
+static void DoTestRoundTrip()
+{
+    MSettingsSerializer serializer(s_fields, FIELD_COUNT);
+    MTestValues values;
+    DoFill(values);
+
+    std::string data;
+    serializer.Serialize(values, data);
+    TEST_CHECK(data.compare(0, 5, "SBST\x01", 5) == 0);
+
+    // the first record: the kind, the name and the varint
+    TEST_CHECK(data.compare(5, 12, "\x01\x05Width\xFF\xFF\xFF\xFF\x0F", 12) == 0);
+
+    MTestValues loaded;
+    TEST_CHECK(serializer.Deserialize(loaded, data));
+    TEST_CHECK(loaded.m_sets == FIELD_COUNT);
+    TEST_CHECK(loaded.m_numbers[0] == 0xFFFFFFFF);
+    TEST_CHECK(loaded.m_strings[1] == values.m_strings[1]);
+    TEST_CHECK(loaded.m_lists[2] == values.m_lists[2]);
+    TEST_CHECK(loaded.m_numbers[3] == 1);
+
+    std::string data2;
+    serializer.Serialize(loaded, data2);
+    TEST_CHECK(data2 == data);
+
+    // the header only
+    TEST_CHECK(serializer.Deserialize(loaded, "SBST\x01"));
+}
+
+static void DoTestSchemaChange()
+{
+    // written by a schema of two fields
+    static const SERIAL_FIELD s_old_fields[] =
+    {
+        { L"Removed", SERIAL_STRING },
+        { L"Secure", SERIAL_STRING },   // another kind
+        { L"Width", SERIAL_NUMBER },
+    };
+    MTestValues old_values;
+    old_values.m_strings[0] = L"gone";
+    old_values.m_strings[1] = L"text";
+    old_values.m_numbers[2] = 640;
+
+    std::string data;
+    MSettingsSerializer(s_old_fields, 3).Serialize(old_values, data);
+
+    // the unknown names and the other kinds are skipped
+    MSettingsSerializer serializer(s_fields, FIELD_COUNT);
+    MTestValues values;
+    DoFill(values);
+    TEST_CHECK(serializer.Deserialize(values, data));
+    TEST_CHECK(values.m_sets == 1);
+    TEST_CHECK(values.m_numbers[0] == 640);
+    TEST_CHECK(values.m_numbers[3] == 1);
+    TEST_CHECK(values.m_lists[2].size() == 3);
+
+    // a prefix of a name doesn't match
+    static const SERIAL_FIELD s_prefix_fields[] = { { L"Wid", SERIAL_NUMBER } };
+    MTestValues prefix_values;
+    TEST_CHECK(MSettingsSerializer(s_prefix_fields, 1).Deserialize(prefix_values, data));
+    TEST_CHECK(prefix_values.m_sets == 0);
+}
+
+static void DoTestBroken()
+{
+    MSettingsSerializer serializer(s_fields, FIELD_COUNT);
+    MTestValues values;
+    DoFill(values);
+    std::string data;
+    serializer.Serialize(values, data);
+
+    // the cuts in the middle of a record fail
+    size_t failures = 0;
+    for (size_t cb = 0; cb < data.size(); ++cb)
+    {
+        MTestValues loaded;
+        if (!serializer.Deserialize(loaded, data.substr(0, cb)))
+            ++failures;
+    }
+    TEST_CHECK(failures == data.size() - 4);  // but after the header and 3 records
+
+    MTestValues loaded;
+    std::string bad = data;
+    bad[0] = 'X';
+    TEST_CHECK(!serializer.Deserialize(loaded, bad));
+    bad = data;
+    bad[4] = 2;
+    TEST_CHECK(!serializer.Deserialize(loaded, bad));
+
+    // an unknown kind
+    TEST_CHECK(!serializer.Deserialize(loaded, std::string("SBST\x01\x09\x01X\x00", 9)));
+
+    // a number beyond 32 bits
+    TEST_CHECK(!serializer.Deserialize(loaded, "SBST\x01\x01\x01X\xFF\xFF\xFF\xFF\x1F"));
+    TEST_CHECK(!serializer.Deserialize(loaded, "SBST\x01\x01\x01X\xFF\xFF\xFF\xFF\xFF\x01"));
+
+    // a list longer than the data
+    TEST_CHECK(!serializer.Deserialize(loaded, "SBST\x01\x03\x03URL\x7F\x01X"));
+    TEST_CHECK(loaded.m_sets == 0);
+}
+
+int main(void)
+{
+    DoTestRoundTrip();
+    DoTestSchemaChange();
+    DoTestBroken();
+    return TEST_RESULT();
+}
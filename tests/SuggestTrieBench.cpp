@@ -0,0 +1,51 @@
+// SuggestTrieBench.cpp --- the benchmark of SuggestTrie
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "SuggestTrie.hpp"
+#include "Test.hpp"
+#include <chrono>
+
+// the searches of a few years, queried like typing each of them
+#define BENCH_TERMS     20000
+#define BENCH_TYPED     2000
+
+int main(void)
+{
+    MSuggestTrie trie;
+    std::vector<std::wstring> texts;
+    unsigned int seed = 1;
+    for (int k = 0; k < BENCH_TERMS; ++k)
+    {
+        std::wstring text;
+        for (int n = 8 + k % 24; n > 0; --n)
+        {
+            seed = seed * 1103515245 + 12345;
+            text += wchar_t(L'a' + (seed >> 16) % 8);
+        }
+        texts.push_back(text);
+        trie.Add(text, 1 + (seed >> 8) % 100);
+    }
+
+    std::vector<std::wstring> results;
+    size_t keystrokes = 0, found = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int k = 0; k < BENCH_TYPED; ++k)
+    {
+        const std::wstring& text = texts[(k * 7919) % texts.size()];
+        for (size_t cch = 1; cch <= text.size(); ++cch)
+        {
+            found += trie.Query(text.substr(0, cch), results);
+            ++keystrokes;
+        }
+    }
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+
+    double us = double(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / 1000;
+    std::printf("MSuggestTrie::Query: %d terms: %.2f us per keystroke\n",
+                BENCH_TERMS, us / keystrokes);
+
+    // every typed prefix has a completion
+    TEST_CHECK(found >= keystrokes);
+    return TEST_RESULT();
+}
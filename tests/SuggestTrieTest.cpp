@@ -0,0 +1,196 @@
+// SuggestTrieTest.cpp --- the test of SuggestTrie
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "SuggestTrie.hpp"
+#include "Test.hpp"
+#include <algorithm>
+#include <functional>
+
+static bool DoIsResult(const MSuggestTrie& trie, const wchar_t *prefix,
+                       const wchar_t *expected0, const wchar_t *expected1 = NULL)
+{
+    std::vector<std::wstring> results;
+    trie.Query(prefix, results);
+    if (results.size() != (expected1 ? 2 : 1))
+        return false;
+    return results[0] == expected0 && (!expected1 || results[1] == expected1);
+}
+
+static void DoTestPrefix()
+{
+    MSuggestTrie trie;
+    trie.Add(L"Weather Tokyo");
+    trie.Add(L"weather osaka", 2);
+    trie.Add(L"wiki");
+    TEST_CHECK(trie.size() == 3);
+
+    // case-insensitive, heaviest first
+    TEST_CHECK(DoIsResult(trie, L"WEA", L"weather osaka", L"Weather Tokyo"));
+    TEST_CHECK(DoIsResult(trie, L"weather t", L"Weather Tokyo"));
+    TEST_CHECK(DoIsResult(trie, L"weather tokyo", L"Weather Tokyo"));
+
+    std::vector<std::wstring> results;
+    TEST_CHECK(trie.Query(L"weather tokyo!", results) == 0);
+    TEST_CHECK(trie.Query(L"x", results) == 0);
+    TEST_CHECK(trie.Query(L"", results) == 0);
+    TEST_CHECK(trie.Query(L"w", results, 1) == 1);
+    TEST_CHECK(results[0] == L"weather osaka");
+
+    // the duplicates add up; the first spelling is kept
+    trie.Add(L"WEATHER TOKYO", 2);
+    TEST_CHECK(trie.size() == 3);
+    TEST_CHECK(DoIsResult(trie, L"weather", L"Weather Tokyo", L"weather osaka"));
+
+    // the non-ASCII letters are folded too
+    trie.Add(L"\x00C9t\x00E9");
+    TEST_CHECK(DoIsResult(trie, L"\x00E9T", L"\x00C9t\x00E9"));
+
+    // ignored
+    trie.Add(L"");
+    trie.Add(L"zero", 0);
+    trie.Add(std::wstring(SUGGEST_MAX_TEXT + 1, L'a'));
+    TEST_CHECK(trie.size() == 4);
+    trie.Add(std::wstring(SUGGEST_MAX_TEXT, L'a'));
+    TEST_CHECK(trie.size() == 5);
+
+    trie.clear();
+    TEST_CHECK(trie.size() == 0);
+    TEST_CHECK(trie.Query(L"w", results) == 0);
+}
+
+static void DoTestOrder()
+{
+    // the equal weights keep the order of the insertion
+    MSuggestTrie trie;
+    for (int i = 0; i < SUGGEST_TOP_COUNT + 4; ++i)
+    {
+        trie.Add(L"q" + std::to_wstring(i));
+    }
+    std::vector<std::wstring> results;
+    TEST_CHECK(trie.Query(L"q", results, 100) == SUGGEST_TOP_COUNT);
+    for (int i = 0; i < SUGGEST_TOP_COUNT; ++i)
+    {
+        TEST_CHECK(results[i] == L"q" + std::to_wstring(i));
+    }
+
+    // a heavier one comes in and moves up past the equal ones
+    trie.Add(L"q10", 2);
+    TEST_CHECK(trie.Query(L"q", results) == SUGGEST_TOP_COUNT);
+    TEST_CHECK(results[0] == L"q10");
+    TEST_CHECK(results[1] == L"q0");
+    TEST_CHECK(results.back() == L"q6");
+}
+
+// the weights of the heaviest terms by scanning all of them
+static void DoBruteForce(const std::vector<std::wstring>& texts,
+                         const std::vector<unsigned long>& weights,
+                         const std::wstring& prefix, std::vector<unsigned long>& results)
+{
+    results.clear();
+    for (size_t i = 0; i < texts.size(); ++i)
+    {
+        if (texts[i].compare(0, prefix.size(), prefix) == 0)
+            results.push_back(weights[i]);
+    }
+    std::sort(results.begin(), results.end(), std::greater<unsigned long>());
+    if (results.size() > SUGGEST_TOP_COUNT)
+        results.resize(SUGGEST_TOP_COUNT);
+}
+
+static void DoTestTopCache()
+{
+    // the cached top of every node matches the scan after random additions.
+    // A term that gets heavier may pass the equal ones, so the weights
+    // are compared.
+    MSuggestTrie trie;
+    std::vector<std::wstring> texts;
+    std::vector<unsigned long> weights;
+    unsigned int seed = 1;
+    for (int k = 0; k < 3000; ++k)
+    {
+        seed = seed * 1103515245 + 12345;
+        std::wstring text;
+        for (int n = 1 + (seed >> 16) % 4; n > 0; --n)
+        {
+            seed = seed * 1103515245 + 12345;
+            text += wchar_t(L'a' + (seed >> 16) % 3);
+        }
+        unsigned long weight = 1 + (seed >> 8) % 5;
+        trie.Add(text, weight);
+
+        size_t i = std::find(texts.begin(), texts.end(), text) - texts.begin();
+        if (i == texts.size())
+        {
+            texts.push_back(text);
+            weights.push_back(0);
+        }
+        weights[i] += weight;
+    }
+    TEST_CHECK(trie.size() == texts.size());
+
+    std::vector<std::wstring> results;
+    std::vector<unsigned long> found, expected;
+    for (size_t i = 0; i < texts.size(); ++i)
+    {
+        for (size_t cch = 1; cch <= texts[i].size(); ++cch)
+        {
+            std::wstring prefix = texts[i].substr(0, cch);
+            trie.Query(prefix, results);
+            found.clear();
+            for (size_t j = 0; j < results.size(); ++j)
+            {
+                size_t k = std::find(texts.begin(), texts.end(), results[j]) - texts.begin();
+                TEST_CHECK(k < texts.size() && results[j].compare(0, cch, prefix) == 0);
+                found.push_back(k < texts.size() ? weights[k] : 0);
+            }
+            DoBruteForce(texts, weights, prefix, expected);
+            TEST_CHECK(found == expected);
+        }
+    }
+}
+
+static void DoTestSerialize()
+{
+    MSuggestTrie trie;
+    trie.Add(L"alpha", 3);
+    trie.Add(L"\x65E5\x672C\x8A9E", 2);
+    trie.Add(L"emoji \xD83D\xDE00");
+    trie.Add(L"big", 0xFFFFFFF0);
+    trie.Add(L"BIG", 0x100);
+
+    std::string data;
+    trie.Serialize(data);
+    TEST_CHECK(data.compare(0, 8, "3\talpha\n") == 0);
+    TEST_CHECK(data.find("4294967295\tbig\n") != std::string::npos);
+
+    MSuggestTrie loaded;
+    loaded.Parse(data);
+    TEST_CHECK(loaded.size() == 4);
+    std::string data2;
+    loaded.Serialize(data2);
+    TEST_CHECK(data2 == data);
+    TEST_CHECK(DoIsResult(loaded, L"\x65E5", L"\x65E5\x672C\x8A9E"));
+    TEST_CHECK(DoIsResult(loaded, L"EMO", L"emoji \xD83D\xDE00"));
+
+    // the lines without a tab, a CRLF and no last newline
+    MSuggestTrie parsed;
+    parsed.Parse("junk\n\n5\tfive\n2\ttwo");
+    TEST_CHECK(parsed.size() == 2);
+    TEST_CHECK(DoIsResult(parsed, L"t", L"two"));
+
+    // it adds to the terms
+    parsed.Parse("1\tfive\n");
+    TEST_CHECK(parsed.size() == 2);
+    parsed.Serialize(data);
+    TEST_CHECK(data == "6\tfive\n2\ttwo\n");
+}
+
+int main(void)
+{
+    DoTestPrefix();
+    DoTestOrder();
+    DoTestTopCache();
+    DoTestSerialize();
+    return TEST_RESULT();
+}
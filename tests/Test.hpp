@@ -0,0 +1,27 @@
+// Test.hpp --- the checks of the tests
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#ifndef TEST_HPP_
+#define TEST_HPP_
+
+#include <cstdio>
+
+// NOTE: This file doesn't depend on Win32 API.
+
+static int s_nFailures = 0;
+
+// prints the failure and goes on
+#define TEST_CHECK(expr) \
+    do { \
+        if (!(expr)) { \
+            std::printf("%s(%d): failed: %s\n", __FILE__, __LINE__, #expr); \
+            ++s_nFailures; \
+        } \
+    } while (0)
+
+// the exit code of main
+#define TEST_RESULT() \
+    (std::printf("%d failure(s)\n", s_nFailures), (s_nFailures ? 1 : 0))
+
+#endif  // ndef TEST_HPP_
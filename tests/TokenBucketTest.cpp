@@ -0,0 +1,183 @@
+// TokenBucketTest.cpp --- the test of TokenBucket
+// Copyright (C) 2019 Katayama Hirofumi MZ <katayama.hirofumi.mz@gmail.com>
+// This file is public domain software.
+
+#include "TokenBucket.hpp"
+#include "Test.hpp"
+#include <thread>
+#include <vector>
+
+// the fake clock, in microseconds
+static TOKEN_TIME s_now = 1000000000;
+
+static TOKEN_TIME DoGetTime(void)
+{
+    return s_now;
+}
+
+static void DoSleep(unsigned long ms)
+{
+    s_now += TOKEN_TIME(ms) * 1000;
+}
+
+static void DoTestBurst()
+{
+    MTokenBucket bucket(DoGetTime);
+    bucket.SetRate(1000);
+
+    // an idle bucket has TOKEN_BUCKET_BURST milliseconds of its rate
+    TEST_CHECK(bucket.Consume(250) == 0);
+    TEST_CHECK(bucket.Consume(1) == 1);
+
+    // the burst doesn't grow while idle
+    DoSleep(60 * 1000);
+    TEST_CHECK(bucket.Consume(250) == 0);
+    TEST_CHECK(bucket.Consume(10) == 10);
+
+    // the tokens come back at the rate
+    DoSleep(110);
+    TEST_CHECK(bucket.Consume(100) == 0);
+    TEST_CHECK(bucket.Consume(100) == 100);
+}
+
+static void DoTestDebt()
+{
+    MTokenBucket bucket(DoGetTime);
+    bucket.SetRate(1000);
+    DoSleep(1000);
+
+    // the tokens are borrowed, and the next consumers wait for the debt too
+    TEST_CHECK(bucket.Consume(1000) == 750);
+    TEST_CHECK(bucket.Consume(500) == 1250);
+
+    // the wait pays it
+    DoSleep(1250);
+    TEST_CHECK(bucket.Consume(1) == 1);
+
+    // rounded up to a millisecond
+    DoSleep(2000);
+    TEST_CHECK(bucket.Consume(251) == 1);
+}
+
+static void DoTestRate()
+{
+    MTokenBucket bucket(DoGetTime);
+
+    // unlimited
+    TEST_CHECK(bucket.GetRate() == 0);
+    TEST_CHECK(bucket.Consume(0xFFFFFFFF) == 0);
+    TEST_CHECK(bucket.Consume(0) == 0);
+
+    // a negative rate would be unlimited
+    bucket.SetRate(0xFFFFFFFF);
+    TEST_CHECK(bucket.GetRate() == TOKEN_BUCKET_MAX_RATE);
+    bucket.SetRate(0x80000000);
+    TEST_CHECK(bucket.GetRate() == TOKEN_BUCKET_MAX_RATE);
+    DoSleep(1000);
+    TEST_CHECK(bucket.Consume(0x7FFFFFFF) == 750);
+
+    bucket.SetRate(TOKEN_BUCKET_MAX_RATE);
+    TEST_CHECK(bucket.GetRate() == TOKEN_BUCKET_MAX_RATE);
+    bucket.SetRate(0);
+    TEST_CHECK(bucket.Consume(0xFFFFFFFF) == 0);
+}
+
+static void DoTestThreads()
+{
+    // the same clock for all, so no token is lost or counted twice
+    MTokenBucket bucket(DoGetTime);
+    bucket.SetRate(1000000);
+    DoSleep(1000);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.push_back(std::thread([&bucket]() {
+            for (int k = 0; k < 10000; ++k)
+            {
+                bucket.Consume(100);
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+
+    // 4000000 bytes are 4000 ms, and the burst was 250 ms
+    TEST_CHECK(bucket.Consume(1000) == 3751);
+}
+
+static void DoTestPause()
+{
+    MDownloadPause pause(DoGetTime);
+    TEST_CHECK(!pause.IsPaused());
+    TEST_CHECK(pause.GetWaitTime() == 0);
+
+    pause.Pause(true);
+    TEST_CHECK(pause.IsPaused());
+    TEST_CHECK(pause.GetWaitTime() == DOWNLOAD_PAUSE_MAX);
+
+    // a nested pause keeps the start
+    DoSleep(10000);
+    pause.Pause(true);
+    TEST_CHECK(pause.GetWaitTime() == DOWNLOAD_PAUSE_MAX - 10000);
+    pause.Pause(false);
+    TEST_CHECK(pause.IsPaused());
+    TEST_CHECK(pause.GetWaitTime() == DOWNLOAD_PAUSE_MAX - 10000);
+    pause.Pause(false);
+    TEST_CHECK(!pause.IsPaused());
+    TEST_CHECK(pause.GetWaitTime() == 0);
+
+    // an extra end is ignored
+    pause.Pause(false);
+    pause.Pause(true);
+    TEST_CHECK(pause.IsPaused());
+    pause.Pause(false);
+    TEST_CHECK(!pause.IsPaused());
+}
+
+static void DoTestPauseBound()
+{
+    MDownloadPause pause(DoGetTime);
+
+    // the pages keep loading one after another for 40 seconds
+    pause.Pause(true);
+    for (int i = 0; i < 20; ++i)
+    {
+        DoSleep(2000);
+        pause.Pause(true);
+        TEST_CHECK(pause.GetWaitTime() ==
+                   (i < 14 ? DOWNLOAD_PAUSE_MAX - 2000 * (i + 1) : 0));
+        pause.Pause(false);
+    }
+
+    // the downloads went on after DOWNLOAD_PAUSE_MAX
+    TEST_CHECK(pause.IsPaused());
+    TEST_CHECK(pause.GetWaitTime() == 0);
+    pause.Pause(false);
+    TEST_CHECK(!pause.IsPaused());
+
+    // the next pause has the whole time again
+    pause.Pause(true);
+    DoSleep(DOWNLOAD_PAUSE_MAX - 1);
+    TEST_CHECK(pause.GetWaitTime() == 1);
+    DoSleep(1);
+    TEST_CHECK(pause.GetWaitTime() == 0);
+
+    // a lost end doesn't pause them again
+    DoSleep(60 * 1000);
+    pause.Pause(true);
+    TEST_CHECK(pause.GetWaitTime() == 0);
+}
+
+int main(void)
+{
+    DoTestBurst();
+    DoTestDebt();
+    DoTestRate();
+    DoTestThreads();
+    DoTestPause();
+    DoTestPauseBound();
+    return TEST_RESULT();
+}